@@ -30,8 +30,12 @@
 #ifndef PLANNER_CSPACE_BLOCKMEM_GRIDMAP_H
 #define PLANNER_CSPACE_BLOCKMEM_GRIDMAP_H
 
+#include <algorithm>
 #include <bitset>
+#include <cstdint>
+#include <cstring>
 #include <limits>
+#include <vector>
 
 #include <planner_cspace/cyclic_vec.h>
 
@@ -47,10 +51,15 @@ public:
   virtual const T operator[](const CyclicVecInt<DIM, NONCYCLIC>& pos) const = 0;
 };
 
+template <class T, int DIM, int NONCYCLIC, int BLOCK_WIDTH, bool ENABLE_VALIDATION>
+class OverlayBlockMemGridmap;
+
 template <class T, int DIM, int NONCYCLIC, int BLOCK_WIDTH = 0x20, bool ENABLE_VALIDATION = false>
 class BlockMemGridmap : public BlockMemGridmapBase<T, DIM, NONCYCLIC>
 {
 private:
+  friend class OverlayBlockMemGridmap<T, DIM, NONCYCLIC, BLOCK_WIDTH, ENABLE_VALIDATION>;
+
   static constexpr bool isPowOf2(const int v)
   {
     return v && ((v & (v - 1)) == 0);
@@ -167,11 +176,35 @@ public:
     : dummy_(std::numeric_limits<T>::max())
   {
   }
-  T& operator[](const CyclicVecInt<DIM, NONCYCLIC>& pos)
+  inline size_t address(const CyclicVecInt<DIM, NONCYCLIC>& pos) const
   {
     size_t baddr, addr;
     block_addr(pos, baddr, addr);
-    const size_t a = baddr * block_ser_size_ + addr;
+    return baddr * block_ser_size_ + addr;
+  }
+  inline CyclicVecInt<DIM, NONCYCLIC> position(const size_t a) const
+  {
+    // Inverse of address()
+    CyclicVecInt<DIM, NONCYCLIC> pos;
+    size_t baddr = a / block_ser_size_;
+    size_t addr = a % block_ser_size_;
+    for (int i = DIM - 1; i >= NONCYCLIC; i--)
+    {
+      pos[i] = addr % size_[i];
+      addr /= size_[i];
+    }
+    for (int i = NONCYCLIC - 1; i >= 0; i--)
+    {
+      pos[i] = addr & block_bit_mask_;
+      addr >>= block_bit_;
+      pos[i] += (baddr % block_size_[i]) << block_bit_;
+      baddr /= block_size_[i];
+    }
+    return pos;
+  }
+  T& operator[](const CyclicVecInt<DIM, NONCYCLIC>& pos)
+  {
+    const size_t a = address(pos);
     if (ENABLE_VALIDATION)
     {
       if (a >= ser_size_)
@@ -181,9 +214,26 @@ public:
   }
   const T operator[](const CyclicVecInt<DIM, NONCYCLIC>& pos) const
   {
-    size_t baddr, addr;
-    block_addr(pos, baddr, addr);
-    const size_t a = baddr * block_ser_size_ + addr;
+    const size_t a = address(pos);
+    if (ENABLE_VALIDATION)
+    {
+      if (a >= ser_size_)
+        return std::numeric_limits<T>::max();
+    }
+    return c_[a];
+  }
+  // Access by the linear address given by address()
+  T& operator[](const size_t a)
+  {
+    if (ENABLE_VALIDATION)
+    {
+      if (a >= ser_size_)
+        return dummy_;
+    }
+    return c_[a];
+  }
+  const T operator[](const size_t a) const
+  {
     if (ENABLE_VALIDATION)
     {
       if (a >= ser_size_)
@@ -209,7 +259,231 @@ public:
       const BlockMemGridmap<T, DIM, NONCYCLIC, BLOCK_WIDTH, ENABLE_VALIDATION>& gm)
   {
     reset(gm.size_);
-    memcpy(c_.get(), gm.c_.get(), ser_size_);
+    memcpy(c_.get(), gm.c_.get(), ser_size_ * sizeof(T));
+
+    return *this;
+  }
+};
+
+// BlockMemGridmap with per-cell generation counter.
+// clear() only increments the generation and the cells written in the older generations
+// are read as the cleared value. The first write access to each cell after clear()
+// resets the cell.
+template <class T, int DIM, int NONCYCLIC, int BLOCK_WIDTH = 0x20, bool ENABLE_VALIDATION = false>
+class EpochBlockMemGridmap : public BlockMemGridmap<T, DIM, NONCYCLIC, BLOCK_WIDTH, ENABLE_VALIDATION>
+{
+protected:
+  using Base = BlockMemGridmap<T, DIM, NONCYCLIC, BLOCK_WIDTH, ENABLE_VALIDATION>;
+
+  std::unique_ptr<uint32_t[]> epoch_;
+  uint32_t epoch_current_;
+  T zero_;
+
+  inline void touch(const size_t a)
+  {
+    if (epoch_[a] != epoch_current_)
+    {
+      epoch_[a] = epoch_current_;
+      this->c_[a] = zero_;
+    }
+  }
+
+public:
+  void clear(const T zero)
+  {
+    zero_ = zero;
+    ++epoch_current_;
+    if (epoch_current_ == 0)
+    {
+      // Generation counter is wrapped around
+      for (size_t i = 0; i < this->ser_size_; i++)
+      {
+        epoch_[i] = 0;
+      }
+      epoch_current_ = 1;
+    }
+  }
+  void clear_positive(const T zero)
+  {
+    for (size_t i = 0; i < this->ser_size_; i++)
+    {
+      touch(i);
+    }
+    Base::clear_positive(zero);
+  }
+  void reset(const CyclicVecInt<DIM, NONCYCLIC>& size)
+  {
+    Base::reset(size);
+    epoch_.reset(new uint32_t[this->ser_size_]);
+    for (size_t i = 0; i < this->ser_size_; i++)
+    {
+      epoch_[i] = 0;
+    }
+    epoch_current_ = 1;
+    zero_ = T();
+  }
+  explicit EpochBlockMemGridmap(const CyclicVecInt<DIM, NONCYCLIC>& size_)
+    : EpochBlockMemGridmap()
+  {
+    reset(size_);
+  }
+  EpochBlockMemGridmap()
+    : epoch_current_(1)
+    , zero_()
+  {
+  }
+  T& operator[](const CyclicVecInt<DIM, NONCYCLIC>& pos)
+  {
+    const size_t a = this->address(pos);
+    if (ENABLE_VALIDATION)
+    {
+      if (a >= this->ser_size_)
+        return this->dummy_;
+    }
+    touch(a);
+    return this->c_[a];
+  }
+  const T operator[](const CyclicVecInt<DIM, NONCYCLIC>& pos) const
+  {
+    const size_t a = this->address(pos);
+    if (ENABLE_VALIDATION)
+    {
+      if (a >= this->ser_size_)
+        return std::numeric_limits<T>::max();
+    }
+    if (epoch_[a] != epoch_current_)
+      return zero_;
+    return this->c_[a];
+  }
+  T& operator[](const size_t a)
+  {
+    if (ENABLE_VALIDATION)
+    {
+      if (a >= this->ser_size_)
+        return this->dummy_;
+    }
+    touch(a);
+    return this->c_[a];
+  }
+  const T operator[](const size_t a) const
+  {
+    if (ENABLE_VALIDATION)
+    {
+      if (a >= this->ser_size_)
+        return std::numeric_limits<T>::max();
+    }
+    if (epoch_[a] != epoch_current_)
+      return zero_;
+    return this->c_[a];
+  }
+  const EpochBlockMemGridmap<T, DIM, NONCYCLIC, BLOCK_WIDTH, ENABLE_VALIDATION>& operator=(
+      const EpochBlockMemGridmap<T, DIM, NONCYCLIC, BLOCK_WIDTH, ENABLE_VALIDATION>& gm)
+  {
+    reset(gm.size_);
+    memcpy(this->c_.get(), gm.c_.get(), this->ser_size_ * sizeof(T));
+    memcpy(epoch_.get(), gm.epoch_.get(), this->ser_size_ * sizeof(uint32_t));
+    epoch_current_ = gm.epoch_current_;
+    zero_ = gm.zero_;
+
+    return *this;
+  }
+};
+
+// BlockMemGridmap overlaid on a base map.
+// Blocks to be written must be marked by markDirty() and restore() copies back
+// only the dirty blocks from the base map.
+template <class T, int DIM, int NONCYCLIC, int BLOCK_WIDTH = 0x20, bool ENABLE_VALIDATION = false>
+class OverlayBlockMemGridmap : public BlockMemGridmap<T, DIM, NONCYCLIC, BLOCK_WIDTH, ENABLE_VALIDATION>
+{
+protected:
+  using Base = BlockMemGridmap<T, DIM, NONCYCLIC, BLOCK_WIDTH, ENABLE_VALIDATION>;
+
+  std::unique_ptr<bool[]> dirty_;
+  std::vector<size_t> dirty_blocks_;
+
+public:
+  void reset(const CyclicVecInt<DIM, NONCYCLIC>& size)
+  {
+    Base::reset(size);
+    dirty_.reset(new bool[this->block_num_]);
+    for (size_t i = 0; i < this->block_num_; i++)
+    {
+      dirty_[i] = false;
+    }
+    dirty_blocks_.clear();
+  }
+  explicit OverlayBlockMemGridmap(const CyclicVecInt<DIM, NONCYCLIC>& size_)
+    : OverlayBlockMemGridmap()
+  {
+    reset(size_);
+  }
+  OverlayBlockMemGridmap()
+  {
+  }
+  // Mark the blocks overlapping [min, max) in the non-cyclic dimensions.
+  void markDirty(const CyclicVecInt<DIM, NONCYCLIC>& min, const CyclicVecInt<DIM, NONCYCLIC>& max)
+  {
+    int bmin[NONCYCLIC];
+    int bmax[NONCYCLIC];
+    for (int i = 0; i < NONCYCLIC; i++)
+    {
+      const int lo = std::max(min[i], 0);
+      const int hi = std::min(max[i], this->size_[i]);
+      if (lo >= hi)
+        return;
+      bmin[i] = lo >> this->block_bit_;
+      bmax[i] = (hi - 1) >> this->block_bit_;
+    }
+    int b[NONCYCLIC];
+    for (int i = 0; i < NONCYCLIC; i++)
+      b[i] = bmin[i];
+    while (true)
+    {
+      size_t baddr = 0;
+      for (int i = 0; i < NONCYCLIC; i++)
+      {
+        baddr *= this->block_size_[i];
+        baddr += b[i];
+      }
+      if (!dirty_[baddr])
+      {
+        dirty_[baddr] = true;
+        dirty_blocks_.push_back(baddr);
+      }
+
+      int i = NONCYCLIC - 1;
+      for (; i >= 0; i--)
+      {
+        if (++b[i] <= bmax[i])
+          break;
+        b[i] = bmin[i];
+      }
+      if (i < 0)
+        break;
+    }
+  }
+  size_t dirtyBlockNum() const
+  {
+    return dirty_blocks_.size();
+  }
+  // Copy the dirty blocks from the base map which has the same size.
+  void restore(const Base& base)
+  {
+    const size_t block_bytes = this->block_ser_size_ * sizeof(T);
+    for (const size_t baddr : dirty_blocks_)
+    {
+      memcpy(
+          this->c_.get() + baddr * this->block_ser_size_,
+          base.c_.get() + baddr * this->block_ser_size_, block_bytes);
+      dirty_[baddr] = false;
+    }
+    dirty_blocks_.clear();
+  }
+  const OverlayBlockMemGridmap<T, DIM, NONCYCLIC, BLOCK_WIDTH, ENABLE_VALIDATION>& operator=(
+      const Base& gm)
+  {
+    reset(gm.size());
+    memcpy(this->c_.get(), gm.c_.get(), this->ser_size_ * sizeof(T));
 
     return *this;
   }
@@ -30,18 +30,25 @@
 #ifndef PLANNER_CSPACE_GRID_ASTAR_H
 #define PLANNER_CSPACE_GRID_ASTAR_H
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <memory>
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <cfloat>
-#include <list>
+#include <cstdint>
+#include <limits>
 #include <map>
-#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <boost/chrono.hpp>
 
-#include <planner_cspace/reservable_priority_queue.h>
+#include <planner_cspace/mpsc_queue.h>
+#include <planner_cspace/selectable_priority_queue.h>
 #include <planner_cspace/cyclic_vec.h>
 #include <planner_cspace/blockmem_gridmap.h>
 
@@ -77,12 +84,25 @@ public:
       std::function<std::vector<Vec>&(
           const Vec&, const Vec&, const Vec&)>;
   using CostEstimFunction = std::function<float(const Vec&, const Vec&)>;
-  using ProgressFunction = std::function<bool(const std::list<Vec>&)>;
+  using ProgressFunction = std::function<bool(const std::vector<Vec>&)>;
 
   template <class T, int block_width = 0x20>
   class Gridmap : public BlockMemGridmap<T, DIM, NONCYCLIC, block_width>
   {
     using BlockMemGridmap<T, DIM, NONCYCLIC, block_width>::BlockMemGridmap;
+
+  public:
+    using BlockMemGridmap<T, DIM, NONCYCLIC, block_width>::operator=;
+  };
+  template <class T, int block_width = 0x20>
+  class EpochGridmap : public EpochBlockMemGridmap<T, DIM, NONCYCLIC, block_width>
+  {
+    using EpochBlockMemGridmap<T, DIM, NONCYCLIC, block_width>::EpochBlockMemGridmap;
+  };
+  template <class T, int block_width = 0x20>
+  class OverlayGridmap : public OverlayBlockMemGridmap<T, DIM, NONCYCLIC, block_width>
+  {
+    using OverlayBlockMemGridmap<T, DIM, NONCYCLIC, block_width>::OverlayBlockMemGridmap;
   };
 
   class PriorityVec
@@ -104,6 +124,15 @@ public:
       return p_ > b.p_;
     }
   };
+  class PriorityVecKey
+  {
+  public:
+    float operator()(const PriorityVec& v) const
+    {
+      return v.p_;
+    }
+  };
+  using OpenList = selectable_priority_queue<PriorityVec, PriorityVecKey>;
   class GridmapUpdate
   {
   private:
@@ -149,27 +178,114 @@ public:
   {
     return NONCYCLIC;
   }
+  // Number of the nodes expanded in parallel on each step.
+  // Zero enables hash distributed A* (HDA*) in which each thread owns
+  // the nodes assigned by the hash of the position.
   void setSearchTaskNum(const size_t& search_task_num)
   {
     search_task_num_ = search_task_num;
   }
 
+  void setQueueType(const PriorityQueueType type)
+  {
+    open_.setType(type);
+  }
+
   void reset(const Vec size)
   {
     g_.reset(size);
     g_.clear(FLT_MAX);
-    parents_.reserve(g_.ser_size() / 16);
+    parents_.reset(size);
+    parents_.clear(PARENT_NONE);
+    assert(parents_.ser_size() < PARENT_NONE);
     open_.reserve(g_.ser_size() / 16);
+    if (incremental_)
+    {
+      state_.reset(size);
+      state_.clear(NODE_UNKNOWN);
+      closed_.reset(size);
+      closed_.clear(0);
+    }
+    invalidateAll();
   }
   GridAstar()
     : queue_size_limit_(0)
     , search_task_num_(1)
+    , incremental_(false)
+    , invalidated_all_(true)
+    , anytime_weight_init_(1.0)
+    , anytime_weight_step_(0.0)
+    , anytime_deadline_(0.0)
+    , suboptimality_bound_(1.0)
+    , expanded_num_(0)
+    , cancel_(false)
   {
   }
   explicit GridAstar(const Vec size)
+    : GridAstar()
   {
     reset(size);
-    queue_size_limit_ = 0;
+  }
+  // Reuse the search tree of the previous search if the start is not changed.
+  // Costs of the edges must not be changed except the ones notified by invalidate().
+  // Not supported on hash distributed A*.
+  void setIncremental(const bool incremental)
+  {
+    incremental_ = incremental;
+    if (incremental_)
+    {
+      state_.reset(g_.size());
+      state_.clear(NODE_UNKNOWN);
+      closed_.reset(g_.size());
+      closed_.clear(0);
+    }
+    invalidateAll();
+  }
+  // Notify that the costs of the edges having an end inside the region
+  // [min, max) of the non-cyclic axes might be changed.
+  void invalidate(const Vec& min, const Vec& max)
+  {
+    invalidated_regions_.emplace_back(min, max);
+  }
+  void invalidateAll()
+  {
+    invalidated_all_ = true;
+    invalidated_regions_.clear();
+  }
+  // Anytime repairing A*.
+  // The first path is searched with the heuristic inflated by weight_init,
+  // then it is improved by decreasing the weight by weight_step
+  // until the weight reaches 1.0 or the deadline [sec] passes.
+  // weight_init = 1.0 disables it. Not supported on hash distributed A*.
+  void setAnytime(const float weight_init, const float weight_step, const float deadline)
+  {
+    anytime_weight_init_ = std::max(1.0f, weight_init);
+    anytime_weight_step_ = weight_step;
+    anytime_deadline_ = deadline;
+  }
+  // Upper bound of the ratio of the cost of the last path to the optimal one.
+  float getSuboptimalityBound() const
+  {
+    return suboptimality_bound_;
+  }
+  // Number of the nodes expanded in the last search.
+  size_t getExpandedNodeNum() const
+  {
+    return expanded_num_;
+  }
+  // Stop the running search and the following searches until resetCancel() is called.
+  // Canceled search returns false without the path. Can be called from the other threads.
+  void cancel()
+  {
+    cancel_ = true;
+  }
+  void resetCancel()
+  {
+    cancel_ = false;
+  }
+  bool isCanceled() const
+  {
+    return cancel_;
   }
   void setQueueSizeLimit(const size_t size)
   {
@@ -178,7 +294,7 @@ public:
 
   bool search(
       const Vec& s, const Vec& e,
-      std::list<Vec>& path,
+      std::vector<Vec>& path,
       CostFunctionSingleStart cb_cost,
       CostEstimFunction cb_cost_estim,
       SearchNextFunctionSingleStart cb_search,
@@ -186,6 +302,44 @@ public:
       const float cost_leave,
       const float progress_interval,
       const bool return_best = false)
+  {
+    return search<
+        CostFunctionSingleStart&, CostEstimFunction&,
+        SearchNextFunctionSingleStart&, ProgressFunction&>(
+        s, e, path,
+        cb_cost, cb_cost_estim, cb_search, cb_progress,
+        cost_leave, progress_interval, return_best);
+  }
+  bool search(
+      const std::vector<VecWithCost>& ss, const Vec& e,
+      std::vector<Vec>& path,
+      CostFunction cb_cost,
+      CostEstimFunction cb_cost_estim,
+      SearchNextFunction cb_search,
+      ProgressFunction cb_progress,
+      const float cost_leave,
+      const float progress_interval,
+      const bool return_best = false)
+  {
+    return searchImpl(
+        g_, ss, e, path,
+        cb_cost, cb_cost_estim, cb_search, cb_progress,
+        cost_leave, progress_interval, return_best);
+  }
+
+  // Overloads taking the types of the callbacks as template parameters.
+  // Unlike std::function, the callbacks called on each edge can be inlined.
+  template <class CB_COST, class CB_COST_ESTIM, class CB_SEARCH, class CB_PROGRESS>
+  bool search(
+      const Vec& s, const Vec& e,
+      std::vector<Vec>& path,
+      CB_COST cb_cost,
+      CB_COST_ESTIM cb_cost_estim,
+      CB_SEARCH cb_search,
+      CB_PROGRESS cb_progress,
+      const float cost_leave,
+      const float progress_interval,
+      const bool return_best = false)
   {
     auto cb_cost_wrapped =
         [&cb_cost](
@@ -206,13 +360,14 @@ public:
         cb_cost_wrapped, cb_cost_estim, cb_search_wrapped, cb_progress,
         cost_leave, progress_interval, return_best);
   }
+  template <class CB_COST, class CB_COST_ESTIM, class CB_SEARCH, class CB_PROGRESS>
   bool search(
       const std::vector<VecWithCost>& ss, const Vec& e,
-      std::list<Vec>& path,
-      CostFunction cb_cost,
-      CostEstimFunction cb_cost_estim,
-      SearchNextFunction cb_search,
-      ProgressFunction cb_progress,
+      std::vector<Vec>& path,
+      CB_COST cb_cost,
+      CB_COST_ESTIM cb_cost_estim,
+      CB_SEARCH cb_search,
+      CB_PROGRESS cb_progress,
       const float cost_leave,
       const float progress_interval,
       const bool return_best = false)
@@ -224,14 +379,70 @@ public:
   }
 
 protected:
+  // Compact node representations used inside the search.
+  // Positions are stored as the linear addresses of the gridmaps and decoded
+  // only when the callbacks or the path need the coordinates.
+  // Cost of the node is not stored but read from g since the priority
+  // of the latest entry of the node is always g + cost_estim * weight.
+  class PriorityNode
+  {
+  public:
+    float p_;
+    uint32_t addr_;
+
+    PriorityNode(const float p, const uint32_t addr)
+      : p_(p)
+      , addr_(addr)
+    {
+    }
+    bool operator<(const PriorityNode& b) const
+    {
+      // smaller first
+      return p_ > b.p_;
+    }
+  };
+  static_assert(sizeof(PriorityNode) == 8, "PriorityNode must be packed in 8 bytes");
+  class PriorityNodeKey
+  {
+  public:
+    float operator()(const PriorityNode& n) const
+    {
+      return n.p_;
+    }
+  };
+  using NodeOpenList = selectable_priority_queue<PriorityNode, PriorityNodeKey>;
+  class NodeUpdate
+  {
+  public:
+    uint32_t addr_;
+    uint32_t parent_;
+    float p_;
+    float cost_;
+
+    NodeUpdate(const uint32_t addr, const uint32_t parent, const float p, const float cost)
+      : addr_(addr)
+      , parent_(parent)
+      , p_(p)
+      , cost_(cost)
+    {
+    }
+  };
+  // Entry is outdated if the node has been reached by the cheaper path after pushed.
+  // Tolerance absorbs the rounding error of the recalculated priority.
+  static bool isStale(const PriorityNode& n, const float g, const float cost_estim_weighted)
+  {
+    return n.p_ > g + cost_estim_weighted + std::abs(n.p_) * 1e-5f;
+  }
+
+  template <class CB_COST, class CB_COST_ESTIM, class CB_SEARCH, class CB_PROGRESS>
   bool searchImpl(
-      Gridmap<float>& g,
+      EpochGridmap<float>& g,
       const std::vector<VecWithCost>& sts, const Vec& en,
-      std::list<Vec>& path,
-      CostFunction cb_cost,
-      CostEstimFunction cb_cost_estim,
-      SearchNextFunction cb_search,
-      ProgressFunction cb_progress,
+      std::vector<Vec>& path,
+      CB_COST& cb_cost,
+      CB_COST_ESTIM& cb_cost_estim,
+      CB_SEARCH& cb_search,
+      CB_PROGRESS& cb_progress,
       const float cost_leave,
       const float progress_interval,
       const bool return_best = false)
@@ -243,13 +454,8 @@ protected:
 
     Vec e = en;
     e.cycleUnsigned(g.size());
-    g.clear(FLT_MAX);
-    open_.clear();
-    parents_.clear();
 
     std::vector<VecWithCost> ss_normalized;
-    Vec better;
-    float cost_estim_min = FLT_MAX;
     for (const VecWithCost& st : sts)
     {
       if (st.v_ == en)
@@ -258,30 +464,80 @@ protected:
       Vec s = st.v_;
       s.cycleUnsigned(g.size());
       ss_normalized.emplace_back(s, st.c_);
-      g[s] = st.c_;
-      open_.emplace(cb_cost_estim(s, e) + st.c_, st.c_, s);
+    }
+
+    const bool anytime = anytime_weight_init_ > 1.0 && search_task_num_ > 0;
+    float weight = anytime ? anytime_weight_init_ : 1.0;
+    suboptimality_bound_ = weight;
+    expanded_num_ = 0;
+
+    const bool incremental = incremental_ && search_task_num_ > 0 && &g == &g_;
+    const bool resumed =
+        incremental && repairSearchTree(ss_normalized, e, cb_search, cb_cost_estim, weight);
+    if (!resumed)
+    {
+      // parents_ is not cleared: the parents are always written together with g,
+      // and the paths are traced only through the nodes reached in this search.
+      g.clear(FLT_MAX);
+      open_.clear();
+      reached_.clear();
+      if (incremental)
+        closed_.clear(0);
+      for (const VecWithCost& s : ss_normalized)
+      {
+        const uint32_t a = g.address(s.v_);
+        g[a] = s.c_;
+        parents_[a] = PARENT_NONE;
+        open_.emplace(s.c_ + cb_cost_estim(s.v_, e) * weight, a);
+        if (incremental)
+          reached_.push_back(a);
+      }
+    }
 
-      const int cost_estim = cb_cost_estim(s, e);
+    Vec better;
+    float cost_estim_min = FLT_MAX;
+    for (const VecWithCost& s : ss_normalized)
+    {
+      const int cost_estim = cb_cost_estim(s.v_, e);
       if (cost_estim_min > cost_estim)
       {
         cost_estim_min = cost_estim;
-        better = s;
+        better = s.v_;
       }
     }
 
-    std::vector<PriorityVec> centers;
+    if (search_task_num_ == 0)
+    {
+      invalidateAll();
+      return searchImplHashDistributed(
+          g, ss_normalized, e, path,
+          cb_cost, cb_cost_estim, cb_search, cb_progress,
+          cost_leave, progress_interval, return_best,
+          better, cost_estim_min);
+    }
+
+    const uint32_t e_addr = g.address(e);
+    std::vector<Vec> centers;
     centers.reserve(search_task_num_);
 
+    const auto ts_start = ts;
+    std::vector<Vec> path_anytime;
+    bool found_anytime(false);
+
     bool found(false);
+    Vec e_found;
+    // Parallel expansions read the costs through the const accessor
+    // not to reset the stale cells concurrently.
+    const EpochGridmap<float>& g_read = g;
 #pragma omp parallel
     {
-      std::vector<GridmapUpdate> updates;
+      std::vector<NodeUpdate> updates;
       // Reserve buffer using example search diff list
       updates.reserve(
           search_task_num_ *
           cb_search(ss_normalized[0].v_, ss_normalized, e).size() /
           omp_get_num_threads());
-      std::vector<Vec> dont;
+      std::vector<uint32_t> dont;
       dont.reserve(search_task_num_);
 
       while (true)
@@ -291,25 +547,96 @@ protected:
         {
           // Fetch tasks to be paralellized
           centers.clear();
+          std::vector<PriorityNode> fetched;
           for (size_t i = 0; i < search_task_num_;)
           {
-            if (open_.size() == 0)
+            if (open_.size() == 0 || cancel_)
               break;
-            PriorityVec center(open_.top());
-            open_.pop();
-            if (center.v_ == e || center.p_ - center.p_raw_ <= cost_leave)
+            // Path to the goal can't be improved if the priorities of all open nodes are not smaller.
+            // Terminating here avoids expanding the nodes having the same priority as the goal.
+            const float g_e = g[e_addr];
+            const bool reached = g_e <= open_.top().p_;
+            const PriorityNode center = reached ? PriorityNode(g_e, e_addr) : open_.top();
+            if (!reached)
+              open_.pop();
+
+            const float gp = g[center.addr_];
+            if (gp < 0)
+              continue;
+            const Vec p = g.position(center.addr_);
+            const float cost_estim = cb_cost_estim(p, e);
+            if (!reached && isStale(center, gp, cost_estim * weight))
+              continue;
+
+            if (reached || center.addr_ == e_addr || cost_estim <= cost_leave)
             {
-              e = center.v_;
+              const bool improve =
+                  weight > 1.0 &&
+                  boost::chrono::duration<float>(
+                      boost::chrono::high_resolution_clock::now() - ts_start).count() < anytime_deadline_;
+              if (incremental || improve)
+              {
+                // Keep the nodes not expanded in this search for the next search.
+                for (const PriorityNode& c : fetched)
+                {
+                  open_.push(c);
+                  if (incremental)
+                    closed_[c.addr_] = 0;
+                }
+                open_.push(center);
+              }
+              if (improve)
+              {
+                // Improve the path by the smaller weight reusing the search state.
+                path_anytime.clear();
+                findPath(ss_normalized, p, path_anytime);
+                found_anytime = true;
+                suboptimality_bound_ = weight;
+
+                const float weight_prev = weight;
+                weight = anytime_weight_step_ > 0 ? std::max(1.0f, weight - anytime_weight_step_) : 1.0f;
+                reweightOpenList(g, e, cb_cost_estim, weight_prev, weight);
+                centers.clear();
+                fetched.clear();
+                i = 0;
+                continue;
+              }
+              e_found = p;
               found = true;
+              suboptimality_bound_ = weight;
               break;
             }
-            centers.emplace_back(std::move(center));
+            if (cost_estim < cost_estim_min)
+            {
+              cost_estim_min = cost_estim;
+              better = p;
+            }
+            if (incremental)
+              closed_[center.addr_] = 1;
+            centers.push_back(p);
+            fetched.push_back(center);
+            ++expanded_num_;
             ++i;
           }
+          if (found_anytime && !found &&
+              boost::chrono::duration<float>(
+                  boost::chrono::high_resolution_clock::now() - ts_start).count() >= anytime_deadline_)
+          {
+            // Deadline passed. Use the last path.
+            if (incremental)
+            {
+              for (const PriorityNode& c : fetched)
+              {
+                open_.push(c);
+                closed_[c.addr_] = 0;
+              }
+            }
+            centers.clear();
+          }
           const auto tnow = boost::chrono::high_resolution_clock::now();
           if (boost::chrono::duration<float>(tnow - ts).count() >= progress_interval)
           {
-            std::list<Vec> path_tmp;
+            std::vector<Vec> path_tmp;
             ts = tnow;
             findPath(ss_normalized, better, path_tmp);
             cb_progress(path_tmp);
@@ -323,20 +650,11 @@ protected:
 #pragma omp for schedule(static)
         for (auto it = centers.cbegin(); it < centers.cend(); ++it)
         {
-          const Vec p = it->v_;
-          const float c = it->p_raw_;
-          const float c_estim = it->p_;
-          const float gp = g[p];
-          if (c > gp)
-            continue;
-
-          if (c_estim - c < cost_estim_min)
-          {
-            cost_estim_min = c_estim - c;
-            better = p;
-          }
+          const Vec& p = *it;
+          const uint32_t p_addr = g_read.address(p);
+          const float c = g_read[p_addr];
 
-          const std::vector<Vec> search_list = cb_search(p, ss_normalized, e);
+          const std::vector<Vec>& search_list = cb_search(p, ss_normalized, e);
 
           bool updated(false);
           for (auto it = search_list.cbegin(); it < search_list.cend(); ++it)
@@ -346,7 +664,9 @@ protected:
             if (next.isExceeded(g.size()))
               continue;
 
-            if (g[next] < gp)
+            const uint32_t next_addr = g_read.address(next);
+            const float g_next = g_read[next_addr];
+            if (g_next < c)
             {
               // Skip as this search task has no chance to find better way.
               continue;
@@ -361,39 +681,64 @@ protected:
               continue;
 
             const float cost_next = c + cost;
-            if (g[next] > cost_next)
+            if (g_next > cost_next)
             {
               updated = true;
-              updates.emplace_back(p, next, cost_next + cost_estim, cost_next);
+              updates.emplace_back(next_addr, p_addr, cost_next + cost_estim * weight, cost_next);
             }
           }
-          if (!updated)
-            dont.push_back(p);
+          if (!updated && !incremental && !anytime)
+            dont.push_back(p_addr);
         }
 #pragma omp barrier
 #pragma omp critical
         {
-          for (const GridmapUpdate& u : updates)
+          for (const NodeUpdate& u : updates)
           {
-            if (g[u.getPos()] > u.getCost())
+            if (g[u.addr_] > u.cost_)
             {
-              g[u.getPos()] = u.getCost();
-              parents_[u.getPos()] = u.getParentPos();
-              open_.push(std::move(u.getPriorityVec()));
+              if (incremental && g[u.addr_] == FLT_MAX)
+                reached_.push_back(u.addr_);
+              g[u.addr_] = u.cost_;
+              parents_[u.addr_] = u.parent_;
+              if (incremental)
+                closed_[u.addr_] = 0;
+              open_.emplace(u.p_, u.addr_);
               if (queue_size_limit_ > 0 && open_.size() > queue_size_limit_)
                 open_.pop_back();
             }
           }
-          for (const Vec& p : dont)
+          for (const uint32_t a : dont)
           {
-            g[p] = -1;
+            g[a] = -1;
           }
         }  // omp critical
       }
     }  // omp parallel
 
+    if (cancel_)
+    {
+      // Search state is partially updated.
+      invalidateAll();
+      return false;
+    }
+    if (!found && found_anytime)
+    {
+      path.swap(path_anytime);
+      return true;
+    }
     if (!found)
     {
+      if (resumed)
+      {
+        // Nodes expanded in the previous searches are not taken into account
+        // to find the best one. Retry from scratch.
+        invalidateAll();
+        return searchImpl(
+            g, sts, en, path,
+            cb_cost, cb_cost_estim, cb_search, cb_progress,
+            cost_leave, progress_interval, return_best);
+      }
       // No fesible path
       if (return_best)
       {
@@ -401,46 +746,521 @@ protected:
       }
       return false;
     }
+    return findPath(ss_normalized, e_found, path);
+  }
+  template <class CB_COST_ESTIM>
+  void reweightOpenList(
+      EpochGridmap<float>& g, const Vec& e,
+      CB_COST_ESTIM& cb_cost_estim,
+      const float weight_prev, const float weight)
+  {
+    std::vector<PriorityNode> opened;
+    opened.reserve(open_.size());
+    while (open_.size() > 0)
+    {
+      opened.push_back(open_.top());
+      open_.pop();
+    }
+    // Reset the last popped key of the monotone queue since the keys may decrease.
+    open_.clear();
+    for (const PriorityNode& o : opened)
+    {
+      const float gp = g[o.addr_];
+      const float cost_estim = cb_cost_estim(g.position(o.addr_), e);
+      if (isStale(o, gp, cost_estim * weight_prev))
+        continue;
+      open_.emplace(gp + cost_estim * weight, o.addr_);
+    }
+  }
+  template <class CB_COST_ESTIM, class CB_SEARCH>
+  bool repairSearchTree(
+      const std::vector<VecWithCost>& ss, const Vec& e,
+      CB_SEARCH& cb_search,
+      CB_COST_ESTIM& cb_cost_estim,
+      const float weight)
+  {
+    bool reusable = !invalidated_all_ && ss.size() == starts_prev_.size();
+    for (size_t i = 0; reusable && i < ss.size(); ++i)
+    {
+      // Cost of the single start just offsets the costs of all nodes.
+      if (ss[i].v_ != starts_prev_[i].v_ ||
+          (ss.size() > 1 && ss[i].c_ != starts_prev_[i].c_))
+        reusable = false;
+    }
+    std::vector<std::pair<Vec, Vec>> regions;
+    regions.swap(invalidated_regions_);
+    invalidated_all_ = false;
+    starts_prev_ = ss;
+    if (!reusable)
+      return false;
+
+    const auto in_regions = [&regions](const Vec& p)
+    {
+      for (const auto& r : regions)
+      {
+        bool in = true;
+        for (int i = 0; i < NONCYCLIC && in; ++i)
+          in = r.first[i] <= p[i] && p[i] < r.second[i];
+        if (in)
+          return true;
+      }
+      return false;
+    };
+
+    // Find the subtrees rooted by the nodes in the invalidated regions.
+    size_t num_dirty = 0;
+    if (regions.size() > 0)
+    {
+      for (const uint32_t a : reached_)
+      {
+        const Vec p = parents_.position(a);
+        // Start nodes are kept even if they are in the regions.
+        if (parents_[p] != PARENT_NONE && in_regions(p))
+          state_[p] = NODE_DIRTY;
+      }
+      std::vector<uint32_t> trace;
+      for (const uint32_t a : reached_)
+      {
+        uint32_t n = a;
+        char state;
+        while (true)
+        {
+          state = state_[parents_.position(n)];
+          if (state != NODE_UNKNOWN)
+            break;
+          trace.push_back(n);
+          n = parents_[parents_.position(n)];
+          if (n == PARENT_NONE)
+          {
+            state = NODE_CLEAN;
+            break;
+          }
+        }
+        for (const uint32_t t : trace)
+          state_[parents_.position(t)] = state;
+        trace.clear();
+      }
+      for (const uint32_t a : reached_)
+      {
+        if (state_[parents_.position(a)] == NODE_DIRTY)
+          ++num_dirty;
+      }
+    }
+    if (num_dirty * 2 > reached_.size())
+    {
+      // Searching from scratch is faster.
+      for (const uint32_t a : reached_)
+        state_[parents_.position(a)] = NODE_UNKNOWN;
+      return false;
+    }
+
+    for (const uint32_t a : reached_)
+    {
+      if (state_[a] == NODE_DIRTY)
+      {
+        g_[a] = FLT_MAX;
+        parents_[a] = PARENT_NONE;
+        closed_[a] = 0;
+      }
+    }
+
+    // Update the priorities by the current cost estimation.
+    // Entries of the expanded nodes are outdated and the duplicated entries are merged.
+    std::vector<PriorityNode> opened;
+    opened.reserve(open_.size());
+    while (open_.size() > 0)
+    {
+      opened.push_back(open_.top());
+      open_.pop();
+    }
+    // Reset the last popped key of the monotone queue since the keys may decrease.
+    open_.clear();
+    for (const PriorityNode& o : opened)
+    {
+      const float gp = g_[o.addr_];
+      if (gp == FLT_MAX || closed_[o.addr_])
+        continue;
+      closed_[o.addr_] = 1;
+      const float cost_estim = cb_cost_estim(g_.position(o.addr_), e);
+      if (cost_estim < 0 || cost_estim == FLT_MAX)
+        continue;
+      open_.emplace(gp + cost_estim * weight, o.addr_);
+    }
+    for (const PriorityNode& o : opened)
+    {
+      if (g_[o.addr_] != FLT_MAX)
+        closed_[o.addr_] = 0;
+    }
+
+    // Expand again the nodes connected to the removed or the changed nodes.
+    std::vector<uint32_t> reached;
+    reached.reserve(reached_.size());
+    for (const uint32_t a : reached_)
+    {
+      const Vec p = parents_.position(a);
+      if (state_[p] == NODE_DIRTY)
+        continue;
+      reached.push_back(a);
+
+      bool expand = regions.size() > 0 && in_regions(p);
+      if (!expand && num_dirty > 0)
+      {
+        for (const Vec& d : cb_search(p, ss, e))
+        {
+          Vec next = p + d;
+          next.cycleUnsigned(g_.size());
+          if (next.isExceeded(g_.size()))
+            continue;
+          if (state_[next] == NODE_DIRTY)
+          {
+            expand = true;
+            break;
+          }
+        }
+      }
+      if (expand)
+      {
+        const float cost_estim = cb_cost_estim(p, e);
+        if (cost_estim < 0 || cost_estim == FLT_MAX)
+          continue;
+        open_.emplace(g_[a] + cost_estim * weight, a);
+        closed_[a] = 0;
+      }
+    }
+    for (const uint32_t a : reached_)
+      state_[parents_.position(a)] = NODE_UNKNOWN;
+    reached_.swap(reached);
+
+    return true;
+  }
+  template <class CB_COST, class CB_COST_ESTIM, class CB_SEARCH, class CB_PROGRESS>
+  bool searchImplHashDistributed(
+      EpochGridmap<float>& g,
+      const std::vector<VecWithCost>& ss_normalized, const Vec& en,
+      std::vector<Vec>& path,
+      CB_COST& cb_cost,
+      CB_COST_ESTIM& cb_cost_estim,
+      CB_SEARCH& cb_search,
+      CB_PROGRESS& cb_progress,
+      const float cost_leave,
+      const float progress_interval,
+      const bool return_best,
+      const Vec& better_init,
+      const float cost_estim_min_init)
+  {
+    auto ts = boost::chrono::high_resolution_clock::now();
+
+    using Batch = std::vector<NodeUpdate>;
+    class Worker
+    {
+    public:
+      NodeOpenList open_;
+      MpscQueue<Batch> inbox_;
+      std::vector<Batch> outbox_;
+      Vec better_;
+      float cost_estim_min_;
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Number of the pending batches and the busy workers.
+    // The search is finished when it reaches zero.
+    std::atomic<int> work(0);
+    std::atomic<int> finished(0);
+    std::atomic<int> paused(0);
+    std::atomic<bool> pause(false);
+
+    std::mutex found_mtx;
+    std::atomic<float> cost_found(FLT_MAX);
+    std::atomic<size_t> expanded_num(0);
+    const uint32_t en_addr = g.address(en);
+    Vec e = en;
+    bool found(false);
+
+    const size_t queue_size_limit = queue_size_limit_;
+
+#pragma omp parallel
+    {
+#pragma omp single
+      {
+        const int num_workers = omp_get_num_threads();
+        for (int i = 0; i < num_workers; ++i)
+        {
+          workers.emplace_back(new Worker);
+          workers.back()->open_.setType(open_.getType());
+          workers.back()->outbox_.resize(num_workers);
+          workers.back()->better_ = better_init;
+          workers.back()->cost_estim_min_ = cost_estim_min_init;
+        }
+        while (open_.size() > 0)
+        {
+          const PriorityNode& s = open_.top();
+          workers[ownerOf(s.addr_, num_workers)]->open_.push(s);
+          open_.pop();
+        }
+        work = num_workers;
+      }  // omp single
+
+      const int num_workers = workers.size();
+      const int id = omp_get_thread_num();
+      Worker& w = *workers[id];
+      bool idle(false);
+
+      while (true)
+      {
+        if (cancel_)
+          break;
+        if (id == 0)
+        {
+          const auto tnow = boost::chrono::high_resolution_clock::now();
+          if (boost::chrono::duration<float>(tnow - ts).count() >= progress_interval)
+          {
+            // Stop the other workers to read consistent parents.
+            pause = true;
+            while (paused + finished < num_workers - 1)
+              std::this_thread::yield();
+
+            const Worker* better = workers[0].get();
+            for (const auto& wb : workers)
+            {
+              if (wb->cost_estim_min_ < better->cost_estim_min_)
+                better = wb.get();
+            }
+            std::vector<Vec> path_tmp;
+            findPath(ss_normalized, better->better_, path_tmp);
+            cb_progress(path_tmp);
+
+            pause = false;
+            ts = boost::chrono::high_resolution_clock::now();
+          }
+        }
+        else if (pause)
+        {
+          ++paused;
+          while (pause)
+            std::this_thread::yield();
+          --paused;
+        }
+
+        w.inbox_.consumeAll(
+            [&](Batch& batch)
+            {
+              if (idle)
+              {
+                ++work;
+                idle = false;
+              }
+              for (const NodeUpdate& u : batch)
+              {
+                if (g[u.addr_] > u.cost_)
+                {
+                  g[u.addr_] = u.cost_;
+                  parents_[u.addr_] = u.parent_;
+                  w.open_.emplace(u.p_, u.addr_);
+                  if (queue_size_limit > 0 && w.open_.size() > queue_size_limit / num_workers)
+                    w.open_.pop_back();
+                }
+              }
+              --work;
+            });
+
+        bool expanded(false);
+        while (w.open_.size() > 0)
+        {
+          const PriorityNode center(w.open_.top());
+          w.open_.pop();
+
+          if (center.p_ >= cost_found)
+          {
+            // No chance to find better path
+            w.open_.clear();
+            break;
+          }
+          const float c = g[center.addr_];
+          const Vec p = g.position(center.addr_);
+          const float cost_estim_p = cb_cost_estim(p, en);
+          if (isStale(center, c, cost_estim_p))
+            continue;
+
+          if (center.addr_ == en_addr || cost_estim_p <= cost_leave)
+          {
+            std::lock_guard<std::mutex> lock(found_mtx);
+            if (center.p_ < cost_found)
+            {
+              cost_found = center.p_;
+              e = p;
+              found = true;
+            }
+            continue;
+          }
+          if (cost_estim_p < w.cost_estim_min_)
+          {
+            w.cost_estim_min_ = cost_estim_p;
+            w.better_ = p;
+          }
+
+          const std::vector<Vec>& search_list = cb_search(p, ss_normalized, en);
+          for (auto it = search_list.cbegin(); it < search_list.cend(); ++it)
+          {
+            Vec next = p + *it;
+            next.cycleUnsigned(g.size());
+            if (next.isExceeded(g.size()))
+              continue;
+
+            // g of the nodes owned by other workers can't be accessed.
+            const uint32_t next_addr = g.address(next);
+            const int owner = ownerOf(next_addr, num_workers);
+            if (owner == id && g[next_addr] < c)
+              continue;
+
+            const float cost_estim = cb_cost_estim(next, en);
+            if (cost_estim < 0 || cost_estim == FLT_MAX)
+              continue;
+
+            const float cost = cb_cost(p, next, ss_normalized, en);
+            if (cost < 0 || cost == FLT_MAX)
+              continue;
+
+            const float cost_next = c + cost;
+            if (owner == id)
+            {
+              if (g[next_addr] > cost_next)
+              {
+                g[next_addr] = cost_next;
+                parents_[next_addr] = center.addr_;
+                w.open_.emplace(cost_next + cost_estim, next_addr);
+                if (queue_size_limit > 0 && w.open_.size() > queue_size_limit / num_workers)
+                  w.open_.pop_back();
+              }
+            }
+            else
+            {
+              w.outbox_[owner].emplace_back(next_addr, center.addr_, cost_next + cost_estim, cost_next);
+            }
+          }
+          for (int i = 0; i < num_workers; ++i)
+          {
+            if (w.outbox_[i].size() == 0)
+              continue;
+            ++work;
+            workers[i]->inbox_.push(std::move(w.outbox_[i]));
+            w.outbox_[i] = Batch();
+          }
+          ++expanded_num;
+          expanded = true;
+          break;
+        }
+        if (expanded)
+          continue;
+
+        if (!idle && w.inbox_.empty())
+        {
+          idle = true;
+          --work;
+        }
+        if (work == 0)
+          break;
+        std::this_thread::yield();
+      }
+      ++finished;
+    }  // omp parallel
+    expanded_num_ += expanded_num;
+
+    if (cancel_)
+      return false;
+    if (!found)
+    {
+      // No fesible path
+      if (return_best)
+      {
+        const Worker* better = workers[0].get();
+        for (const auto& wb : workers)
+        {
+          if (wb->cost_estim_min_ < better->cost_estim_min_)
+            better = wb.get();
+        }
+        findPath(ss_normalized, better->better_, path);
+      }
+      return false;
+    }
     return findPath(ss_normalized, e, path);
   }
-  bool findPath(const Vec& s, const Vec& e, std::list<Vec>& path) const
+  static int ownerOf(const uint32_t addr, const int num_workers)
+  {
+    // Mix the bits of the address to distribute neighboring grids
+    // to the different workers.
+    const uint64_t h = static_cast<uint64_t>(addr) * 0x9E3779B97F4A7C15ull;
+    return static_cast<int>((h >> 32) % num_workers);
+  }
+  bool findPath(const Vec& s, const Vec& e, std::vector<Vec>& path) const
   {
     return findPath(std::vector<VecWithCost>(1, VecWithCost(s)), e, path);
   }
-  bool findPath(const std::vector<VecWithCost>& ss, const Vec& e, std::list<Vec>& path) const
+  bool findPath(const std::vector<VecWithCost>& ss, const Vec& e, std::vector<Vec>& path) const
   {
-    std::unordered_map<Vec, Vec, Vec> parents = parents_;
+    // Path can't be longer than the number of the grids.
+    // Exceeding it means that the parents are looped.
+    const size_t step_max = parents_.ser_size();
+    // Nodes are traced from the end and reversed at last.
+    const size_t path_begin = path.size();
+    bool reached(false);
     Vec n = e;
-    while (true)
+    for (size_t step = 0; step <= step_max; ++step)
     {
-      path.push_front(n);
+      path.push_back(n);
 
-      bool found(false);
       for (const VecWithCost& s : ss)
       {
         if (n == s.v_)
-        {
-          found = true;
-          break;
-        }
+          reached = true;
       }
-      if (found)
+      if (reached)
+        break;
+      const uint32_t parent = parents_[n];
+      if (parent == PARENT_NONE)
         break;
-      if (parents.find(n) == parents.end())
-        return false;
 
-      const Vec child = n;
-      n = parents[child];
-      parents.erase(child);
+      n = parents_.position(parent);
     }
-    return true;
+    std::reverse(path.begin() + path_begin, path.end());
+    return reached;
   }
 
-  Gridmap<float> g_;
-  std::unordered_map<Vec, Vec, Vec> parents_;
-  reservable_priority_queue<PriorityVec> open_;
+  // Parent of each grid is stored as a linear address of the parents_ map
+  // to avoid hashing and to keep the memory footprint same as g_.
+  static constexpr uint32_t PARENT_NONE = std::numeric_limits<uint32_t>::max();
+
+  // State of the nodes used to find the subtrees to be repaired.
+  enum : char
+  {
+    NODE_UNKNOWN = 0,
+    NODE_CLEAN,
+    NODE_DIRTY,
+  };
+
+  EpochGridmap<float> g_;
+  Gridmap<uint32_t> parents_;
+  NodeOpenList open_;
   size_t queue_size_limit_;
   size_t search_task_num_;
+
+  bool incremental_;
+  bool invalidated_all_;
+  std::vector<std::pair<Vec, Vec>> invalidated_regions_;
+  std::vector<VecWithCost> starts_prev_;
+  std::vector<uint32_t> reached_;
+  Gridmap<char> state_;
+  // Nodes expanded after the last update of the cost.
+  Gridmap<char> closed_;
+
+  float anytime_weight_init_;
+  float anytime_weight_step_;
+  float anytime_deadline_;
+  float suboptimality_bound_;
+  size_t expanded_num_;
+  std::atomic<bool> cancel_;
 };
 
+template <int DIM, int NONCYCLIC>
+constexpr uint32_t GridAstar<DIM, NONCYCLIC>::PARENT_NONE;
+
 #endif  // PLANNER_CSPACE_GRID_ASTAR_H
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_MIN_MAX_HEAP_H
+#define PLANNER_CSPACE_MIN_MAX_HEAP_H
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Double-ended priority queue.
+// top() and pop() work as std::priority_queue and pop_back() removes
+// the element with the lowest priority in O(log n),
+// so that a size-limited queue drops the worst element.
+template <class T, class Compare = std::less<T>>
+class min_max_heap
+{
+public:
+  typedef typename std::vector<T>::size_type size_type;
+
+  explicit min_max_heap(const size_type capacity = 0)
+  {
+    reserve(capacity);
+  }
+  void reserve(const size_type capacity)
+  {
+    c_.reserve(capacity);
+  }
+  size_type capacity() const
+  {
+    return c_.capacity();
+  }
+  size_type size() const
+  {
+    return c_.size();
+  }
+  bool empty() const
+  {
+    return c_.empty();
+  }
+  void clear()
+  {
+    c_.clear();
+  }
+  const T& top() const
+  {
+    return c_.front();
+  }
+  const T& bottom() const
+  {
+    return c_[bottomIndex()];
+  }
+  void push(const T& v)
+  {
+    c_.push_back(v);
+    bubbleUp(c_.size() - 1);
+  }
+  void push(T&& v)
+  {
+    c_.push_back(std::move(v));
+    bubbleUp(c_.size() - 1);
+  }
+  template <class... Args>
+  void emplace(Args&&... args)
+  {
+    c_.emplace_back(std::forward<Args>(args)...);
+    bubbleUp(c_.size() - 1);
+  }
+  void pop()
+  {
+    remove(0);
+  }
+  void pop_back()
+  {
+    remove(bottomIndex());
+  }
+
+protected:
+  std::vector<T> c_;
+  Compare comp_;
+
+  // Elements on the even levels are higher than their descendants and
+  // the ones on the odd levels are lower than their descendants.
+  bool higher(const size_type a, const size_type b) const
+  {
+    return comp_(c_[b], c_[a]);
+  }
+  static bool isHighLevel(const size_type i)
+  {
+    int level = 0;
+    for (size_type n = i + 1; n > 1; n >>= 1)
+      ++level;
+    return (level & 1) == 0;
+  }
+  size_type bottomIndex() const
+  {
+    if (c_.size() <= 2)
+      return c_.size() - 1;
+    return higher(1, 2) ? 2 : 1;
+  }
+  void remove(const size_type i)
+  {
+    if (i + 1 != c_.size())
+      c_[i] = std::move(c_.back());
+    c_.pop_back();
+    if (i < c_.size())
+      trickleDown(i);
+  }
+  void bubbleUp(size_type i)
+  {
+    if (i == 0)
+      return;
+    const size_type p = (i - 1) / 2;
+    const bool high = isHighLevel(i);
+    if (high ? higher(p, i) : higher(i, p))
+    {
+      // Violates the order against the parent on the other kind of level.
+      std::swap(c_[i], c_[p]);
+      bubbleUpGrandparent(p, !high);
+    }
+    else
+    {
+      bubbleUpGrandparent(i, high);
+    }
+  }
+  void bubbleUpGrandparent(size_type i, const bool high)
+  {
+    while (i >= 3)
+    {
+      const size_type gp = ((i - 1) / 2 - 1) / 2;
+      if (!(high ? higher(i, gp) : higher(gp, i)))
+        break;
+      std::swap(c_[i], c_[gp]);
+      i = gp;
+    }
+  }
+  void trickleDown(size_type i)
+  {
+    const bool high = isHighLevel(i);
+    const auto prior = [this, high](const size_type a, const size_type b)
+    {
+      return high ? higher(a, b) : higher(b, a);
+    };
+    while (true)
+    {
+      const size_type child = 2 * i + 1;
+      if (child >= c_.size())
+        return;
+
+      // Find the most prior one from the children and the grandchildren.
+      size_type m = child;
+      const size_type candidates[] = { child + 1, 2 * child + 1, 2 * child + 2, 2 * child + 3, 2 * child + 4 };
+      for (const size_type j : candidates)
+      {
+        if (j < c_.size() && prior(j, m))
+          m = j;
+      }
+      if (!prior(m, i))
+        return;
+
+      std::swap(c_[m], c_[i]);
+      if (m <= child + 1)
+        return;
+
+      const size_type p = (m - 1) / 2;
+      if (prior(p, m))
+        std::swap(c_[m], c_[p]);
+      i = m;
+    }
+  }
+};
+
+#endif  // PLANNER_CSPACE_MIN_MAX_HEAP_H
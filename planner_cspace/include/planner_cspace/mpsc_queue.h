@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_MPSC_QUEUE_H
+#define PLANNER_CSPACE_MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// Lock-free multiple-producer single-consumer queue.
+// Producers push elements with a CAS on the list head and the consumer takes
+// all pending elements at once, so no ABA problem arises.
+template <class T>
+class MpscQueue
+{
+private:
+  class Node
+  {
+  public:
+    T value_;
+    Node* next_;
+
+    explicit Node(T&& value)
+      : value_(std::move(value))
+      , next_(nullptr)
+    {
+    }
+  };
+  std::atomic<Node*> head_;
+
+public:
+  MpscQueue()
+    : head_(nullptr)
+  {
+  }
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+  ~MpscQueue()
+  {
+    Node* n = head_.exchange(nullptr);
+    while (n)
+    {
+      Node* next = n->next_;
+      delete n;
+      n = next;
+    }
+  }
+  void push(T&& value)
+  {
+    Node* n = new Node(std::move(value));
+    n->next_ = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(
+        n->next_, n, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+  }
+  bool empty() const
+  {
+    return head_.load(std::memory_order_acquire) == nullptr;
+  }
+  // Calls cb for each pending element in the pushed order.
+  // Must be called only from the consumer thread.
+  template <class CALLBACK>
+  bool consumeAll(CALLBACK cb)
+  {
+    Node* n = head_.exchange(nullptr, std::memory_order_acquire);
+    if (!n)
+      return false;
+
+    Node* reversed = nullptr;
+    while (n)
+    {
+      Node* next = n->next_;
+      n->next_ = reversed;
+      reversed = n;
+      n = next;
+    }
+    while (reversed)
+    {
+      Node* next = reversed->next_;
+      cb(reversed->value_);
+      delete reversed;
+      reversed = next;
+    }
+    return true;
+  }
+};
+
+#endif  // PLANNER_CSPACE_MPSC_QUEUE_H
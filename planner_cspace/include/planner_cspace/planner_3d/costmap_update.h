@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_PLANNER_3D_COSTMAP_UPDATE_H
+#define PLANNER_CSPACE_PLANNER_3D_COSTMAP_UPDATE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <planner_cspace/blockmem_gridmap.h>
+#include <planner_cspace/cyclic_vec.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+// Walk the cells in [pos, pos + size) block by block of cm in parallel.
+// data is given in (yaw, y, x) order, the layout of CSpace3D::data and CSpace3DUpdate::data.
+// cb(p, column, dst) is called for each (x, y) with the costs along the yaw gathered from data
+// and the pointer to the consecutive cells of cm along the yaw.
+// It is called concurrently from the threads but never twice for the same (x, y).
+template <int BLOCK_WIDTH, bool ENABLE_VALIDATION, class CB>
+void forEachCostmapColumn(
+    BlockMemGridmap<char, 3, 2, BLOCK_WIDTH, ENABLE_VALIDATION>& cm,
+    const CyclicVecInt<3, 2>& pos,
+    const CyclicVecInt<3, 2>& size,
+    const int8_t* data,
+    CB cb)
+{
+  using Vec = CyclicVecInt<3, 2>;
+
+  const int x_min = std::max(pos[0], 0);
+  const int y_min = std::max(pos[1], 0);
+  const int x_max = std::min(pos[0] + size[0], cm.size()[0]);
+  const int y_max = std::min(pos[1] + size[1], cm.size()[1]);
+  const int angle = size[2];
+  if (x_min >= x_max || y_min >= y_max || angle <= 0)
+    return;
+
+  const int bx_min = x_min / BLOCK_WIDTH;
+  const int by_min = y_min / BLOCK_WIDTH;
+  const int bx_num = (x_max - 1) / BLOCK_WIDTH - bx_min + 1;
+  const int by_num = (y_max - 1) / BLOCK_WIDTH - by_min + 1;
+  const size_t plane_size = static_cast<size_t>(size[0]) * size[1];
+  constexpr int ROW_BAND = 8;
+
+  // Blocks are ordered same as the memory of cm.
+#pragma omp parallel
+  {
+    std::vector<char> column(angle);
+
+#pragma omp for schedule(static)
+    for (int b = 0; b < bx_num * by_num; ++b)
+    {
+      const int bx = bx_min + b / by_num;
+      const int by = by_min + b % by_num;
+      const int x0 = std::max(bx * BLOCK_WIDTH, x_min);
+      const int y0 = std::max(by * BLOCK_WIDTH, y_min);
+      const int x1 = std::min((bx + 1) * BLOCK_WIDTH, x_max);
+      const int y1 = std::min((by + 1) * BLOCK_WIDTH, y_max);
+
+      // Rows of data are read in the bands of a few y to keep them in the cache
+      // while the columns are gathered along x.
+      for (int yb = y0; yb < y1; yb += ROW_BAND)
+      {
+        const int yb1 = std::min(yb + ROW_BAND, y1);
+        for (int x = x0; x < x1; ++x)
+        {
+          for (int y = yb; y < yb1; ++y)
+          {
+            const int8_t* src = data + static_cast<size_t>(y - pos[1]) * size[0] + (x - pos[0]);
+            for (int yaw = 0; yaw < angle; ++yaw)
+              column[yaw] = src[yaw * plane_size];
+
+            // Cells of the same (x, y) are consecutive in the block.
+            const Vec p(x, y, pos[2]);
+            cb(p, column.data(), &cm[cm.address(p)]);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Merge the partial C-space costs into cm at pos.
+// If overwrite is set, non-negative costs overwrite cm, otherwise the larger costs are kept.
+// cb_column(p, column) is called with the gathered costs of each (x, y) before the merge
+// in the same manner as forEachCostmapColumn().
+template <int BLOCK_WIDTH, bool ENABLE_VALIDATION, class CB_COLUMN>
+void mergeCostmapUpdate(
+    BlockMemGridmap<char, 3, 2, BLOCK_WIDTH, ENABLE_VALIDATION>& cm,
+    const CyclicVecInt<3, 2>& pos,
+    const CyclicVecInt<3, 2>& size,
+    const int8_t* data,
+    const bool overwrite,
+    CB_COLUMN cb_column)
+{
+  const int angle = size[2];
+  forEachCostmapColumn(
+      cm, pos, size, data,
+      [angle, overwrite, &cb_column](const CyclicVecInt<3, 2>& p, char* column, char* dst)
+      {
+        cb_column(p, column);
+        if (overwrite)
+        {
+          for (int yaw = 0; yaw < angle; ++yaw)
+            dst[yaw] = column[yaw] >= 0 ? column[yaw] : dst[yaw];
+        }
+        else
+        {
+          for (int yaw = 0; yaw < angle; ++yaw)
+            dst[yaw] = std::max(dst[yaw], column[yaw]);
+        }
+      });
+}
+
+// Import the whole C-space costs into cm having the same size.
+// Negative (unknown) costs are replaced by unknown_cost.
+// cb_column(p, column) is called with the replaced costs of each (x, y)
+// in the same manner as forEachCostmapColumn().
+template <int BLOCK_WIDTH, bool ENABLE_VALIDATION, class CB_COLUMN>
+void importCostmap(
+    BlockMemGridmap<char, 3, 2, BLOCK_WIDTH, ENABLE_VALIDATION>& cm,
+    const int8_t* data,
+    const char unknown_cost,
+    CB_COLUMN cb_column)
+{
+  const int angle = cm.size()[2];
+  forEachCostmapColumn(
+      cm, CyclicVecInt<3, 2>(0, 0, 0), cm.size(), data,
+      [angle, unknown_cost, &cb_column](const CyclicVecInt<3, 2>& p, char* column, char* dst)
+      {
+        for (int yaw = 0; yaw < angle; ++yaw)
+          column[yaw] = column[yaw] < 0 ? unknown_cost : column[yaw];
+        cb_column(p, column);
+        std::copy(column, column + angle, dst);
+      });
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+#endif  // PLANNER_CSPACE_PLANNER_3D_COSTMAP_UPDATE_H
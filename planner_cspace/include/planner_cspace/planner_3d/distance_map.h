@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_PLANNER_3D_DISTANCE_MAP_H
+#define PLANNER_CSPACE_PLANNER_3D_DISTANCE_MAP_H
+
+#include <utility>
+#include <vector>
+
+#include <planner_cspace/blockmem_gridmap.h>
+#include <planner_cspace/cyclic_vec.h>
+#include <planner_cspace/planner_3d/costmap_bbf.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+// 2D cost-to-goal field used as the heuristic of the 3D search.
+// Costs are propagated by the delta-stepping algorithm:
+// cells in the same cost bucket are expanded in parallel.
+// The motion to each cell is stored to repair the field incrementally on the costmap update.
+class DistanceMap
+{
+public:
+  using Vec = CyclicVecInt<3, 2>;
+  using Costmap = BlockMemGridmap<char, 3, 2, 0x80>;
+  using Gridmap = EpochBlockMemGridmap<float, 3, 2, 0x20>;
+
+  struct Params
+  {
+    float euclid_cost;
+    float resolution;
+    float weight_costmap;
+    float weight_remembered;
+  };
+  // Rectangle [first, second) on the map.
+  using Region = std::pair<Vec, Vec>;
+
+  // Propagation state associated to the filled field.
+  // Saving it together with the field allows to repair the field later.
+  struct State
+  {
+    // Index of search_diffs_ reached to the cell.
+    BlockMemGridmap<char, 3, 2, 0x80> parents;
+    // Cells not expanded due to the distance from the start.
+    std::vector<Vec> pending;
+  };
+
+protected:
+  struct SearchDiffs
+  {
+    Vec d;
+    std::vector<Vec> pos;
+    float grid_to_len;
+    float euclid_cost;
+  };
+  const Costmap& cm_rough_;
+  const CostmapBBF& bbf_costmap_;
+  Params p_;
+  std::vector<SearchDiffs> search_diffs_;
+  // Width of the cost bucket and the number of the buckets covering the most expensive motion.
+  float bucket_width_;
+  size_t bucket_num_;
+  State state_;
+
+  static constexpr char PARENT_NONE = -1;
+
+  void propagate(
+      Gridmap& g,
+      const std::vector<Vec>& seeds,
+      const Vec& s,
+      const float range_overshoot);
+
+public:
+  DistanceMap(const Costmap& cm_rough, const CostmapBBF& bbf);
+  void setParams(const Params& p);
+
+  // Propagate the costs from the seeds, whose costs must be set to g beforehand.
+  // Cells having the cost larger than g[s] + range_overshoot are not expanded.
+  void fill(
+      Gridmap& g,
+      const std::vector<Vec>& seeds,
+      const Vec& s,
+      const float range_overshoot);
+  // Repair g filled by fill() after the costmap in the regions is changed.
+  // Costs passing through the regions are invalidated and propagated again
+  // from the surrounding cells and the cells pending in the last propagation.
+  void update(
+      Gridmap& g,
+      const std::vector<Region>& regions,
+      const Vec& s,
+      const float range_overshoot);
+  void update(
+      Gridmap& g,
+      const Vec& region_min,
+      const Vec& region_max,
+      const Vec& s,
+      const float range_overshoot)
+  {
+    update(g, std::vector<Region>(1, Region(region_min, region_max)), s, range_overshoot);
+  }
+
+  const State& getState() const
+  {
+    return state_;
+  }
+  void setState(const State& state)
+  {
+    state_ = state;
+  }
+};
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+#endif  // PLANNER_CSPACE_PLANNER_3D_DISTANCE_MAP_H
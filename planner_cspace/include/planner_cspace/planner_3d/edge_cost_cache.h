@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_PLANNER_3D_EDGE_COST_CACHE_H
+#define PLANNER_CSPACE_PLANNER_3D_EDGE_COST_CACHE_H
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+
+#include <planner_cspace/cyclic_vec.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+// Costs of the edges of the search graph keyed by the start cell and the index of the edge.
+// The storage is allocated lazily for each block of the cells touched by the search
+// and released by the block-wise invalidation.
+// find() and insert() can be called concurrently, other methods must not be called during the search.
+class EdgeCostCache
+{
+public:
+  using Vec = CyclicVecInt<3, 2>;
+
+protected:
+  static constexpr int BLOCK_BIT = 3;
+  static constexpr int BLOCK_WIDTH = 1 << BLOCK_BIT;
+
+  Vec size_;
+  Vec block_size_;
+  size_t edge_num_;
+  size_t block_mem_;
+  size_t memory_limit_;
+  std::atomic<size_t> memory_used_;
+  std::unique_ptr<std::atomic<std::atomic<float>*>[]> blocks_;
+
+  inline size_t blockAddress(const Vec& p) const
+  {
+    return static_cast<size_t>(p[1] >> BLOCK_BIT) * block_size_[0] + (p[0] >> BLOCK_BIT);
+  }
+  inline size_t addressInBlock(const Vec& p, const size_t edge) const
+  {
+    const size_t cell =
+        (static_cast<size_t>(p[2]) * BLOCK_WIDTH + (p[1] & (BLOCK_WIDTH - 1))) * BLOCK_WIDTH +
+        (p[0] & (BLOCK_WIDTH - 1));
+    return cell * edge_num_ + edge;
+  }
+  std::atomic<float>* allocate(const size_t baddr);
+  void release(const size_t baddr);
+
+public:
+  EdgeCostCache();
+  ~EdgeCostCache();
+
+  // Cache is disabled if memory_limit [bytes] is not enough to store one block.
+  void reset(const Vec& size, const size_t edge_num, const size_t memory_limit);
+  // Drop the costs of the edges starting from [min, max) in the non-cyclic dimensions.
+  void invalidate(const Vec& min, const Vec& max);
+  void invalidateAll();
+
+  inline bool enabled() const
+  {
+    return blocks_ != nullptr;
+  }
+  inline size_t memoryUsed() const
+  {
+    return memory_used_;
+  }
+  inline bool find(const Vec& p, const size_t edge, float& cost) const
+  {
+    if (!enabled())
+      return false;
+    const std::atomic<float>* block = blocks_[blockAddress(p)].load(std::memory_order_acquire);
+    if (block == nullptr)
+      return false;
+    const float c = block[addressInBlock(p, edge)].load(std::memory_order_relaxed);
+    if (std::isnan(c))
+      return false;
+    cost = c;
+    return true;
+  }
+  inline void insert(const Vec& p, const size_t edge, const float cost)
+  {
+    if (!enabled())
+      return;
+    const size_t baddr = blockAddress(p);
+    std::atomic<float>* block = blocks_[baddr].load(std::memory_order_acquire);
+    if (block == nullptr)
+    {
+      block = allocate(baddr);
+      if (block == nullptr)
+        return;
+    }
+    block[addressInBlock(p, edge)].store(cost, std::memory_order_relaxed);
+  }
+};
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+#endif  // PLANNER_CSPACE_PLANNER_3D_EDGE_COST_CACHE_H
@@ -36,7 +36,6 @@
 
 #include <planner_cspace/cyclic_vec.h>
 
-#include <list>
 #include <memory>
 
 namespace grid_metric_converter
@@ -73,13 +72,13 @@ inline void metric2Grid(
   yaw = gyaw / map_info.angular_resolution;
 }
 
-template <template <class, class> class STL_CONTAINER = std::list>
+template <class CONTAINER>
 void grid2MetricPath(
     const costmap_cspace_msgs::MapMetaData3D& map_info,
-    const STL_CONTAINER<CyclicVecFloat<3, 2>,
-                        std::allocator<CyclicVecFloat<3, 2>>>& path_grid,
+    const CONTAINER& path_grid,
     nav_msgs::Path& path)
 {
+  path.poses.reserve(path.poses.size() + path_grid.size());
   for (const auto& p : path_grid)
   {
     float x, y, yaw;
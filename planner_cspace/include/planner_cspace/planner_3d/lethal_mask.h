@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_PLANNER_3D_LETHAL_MASK_H
+#define PLANNER_CSPACE_PLANNER_3D_LETHAL_MASK_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <planner_cspace/cyclic_vec.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+// One bit per cell flag of the lethal cells.
+// Collision of a motion is checked by a few AND operations of the footprint rows
+// instead of reading the costs of all cells along the motion.
+class LethalMask
+{
+public:
+  using Vec = CyclicVecInt<3, 2>;
+
+  // Cells of the footprint in [dx, dx + 64) on the row (dy, yaw) as the bits of the mask.
+  struct Row
+  {
+    int dx;
+    int dy;
+    int yaw;
+    uint64_t mask;
+  };
+  using Footprint = std::vector<Row>;
+
+protected:
+  // Rows are padded by one word on both sides to read the words around the edges.
+  static constexpr int PAD = 64;
+
+  Vec size_;
+  size_t row_words_;
+  std::vector<uint64_t> bits_;
+
+  inline size_t rowAddress(const int y, const int yaw) const
+  {
+    return (static_cast<size_t>(yaw) * size_[1] + y) * row_words_;
+  }
+
+public:
+  LethalMask()
+    : size_(0, 0, 0)
+    , row_words_(0)
+  {
+  }
+  void reset(const Vec& size)
+  {
+    size_ = size;
+    row_words_ = (size[0] + PAD * 2 + 63) / 64;
+    bits_.assign(row_words_ * size[1] * size[2], 0);
+  }
+  inline void set(const Vec& p, const bool lethal)
+  {
+    const size_t x = p[0] + PAD;
+    uint64_t& word = bits_[rowAddress(p[1], p[2]) + (x >> 6)];
+    const uint64_t bit = static_cast<uint64_t>(1) << (x & 63);
+    if (lethal)
+      word |= bit;
+    else
+      word &= ~bit;
+  }
+  inline bool get(const Vec& p) const
+  {
+    const size_t x = p[0] + PAD;
+    return (bits_[rowAddress(p[1], p[2]) + (x >> 6)] >> (x & 63)) & 1;
+  }
+  // Copy the lethal flags of the cells in [min, max) in the non-cyclic dimensions from the costmap.
+  template <class T>
+  void update(const T& cm, const Vec& min, const Vec& max)
+  {
+    const int x_min = std::max(min[0], 0);
+    const int y_min = std::max(min[1], 0);
+    const int x_max = std::min(max[0], size_[0]);
+    const int y_max = std::min(max[1], size_[1]);
+    Vec p;
+    for (p[2] = 0; p[2] < size_[2]; p[2]++)
+    {
+      for (p[1] = y_min; p[1] < y_max; p[1]++)
+      {
+        for (p[0] = x_min; p[0] < x_max; p[0]++)
+        {
+          set(p, cm[p] > 99);
+        }
+      }
+    }
+  }
+  // Footprint must be inside the map.
+  inline bool collides(const Vec& s, const Footprint& footprint) const
+  {
+    for (const Row& row : footprint)
+    {
+      const size_t x = s[0] + row.dx + PAD;
+      const size_t addr = rowAddress(s[1] + row.dy, row.yaw) + (x >> 6);
+      const int shift = x & 63;
+      uint64_t window = bits_[addr] >> shift;
+      if (shift != 0)
+        window |= bits_[addr + 1] << (64 - shift);
+      if (window & row.mask)
+        return true;
+    }
+    return false;
+  }
+  // Create the footprint from the cells given as (dx, dy, yaw).
+  template <class T>
+  static Footprint createFootprint(const T& cells)
+  {
+    std::map<std::pair<int, int>, std::vector<int>> rows;
+    for (const Vec& c : cells)
+      rows[std::make_pair(c[2], c[1])].push_back(c[0]);
+
+    Footprint footprint;
+    for (auto& r : rows)
+    {
+      std::vector<int>& xs = r.second;
+      std::sort(xs.begin(), xs.end());
+      Row row;
+      row.yaw = r.first.first;
+      row.dy = r.first.second;
+      row.dx = xs.front();
+      row.mask = 0;
+      for (const int x : xs)
+      {
+        if (x - row.dx >= 64)
+        {
+          footprint.push_back(row);
+          row.dx = x;
+          row.mask = 0;
+        }
+        row.mask |= static_cast<uint64_t>(1) << (x - row.dx);
+      }
+      footprint.push_back(row);
+    }
+    return footprint;
+  }
+};
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+#endif  // PLANNER_CSPACE_PLANNER_3D_LETHAL_MASK_H
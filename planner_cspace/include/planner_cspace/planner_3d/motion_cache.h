@@ -30,7 +30,12 @@
 #ifndef PLANNER_CSPACE_PLANNER_3D_MOTION_CACHE_H
 #define PLANNER_CSPACE_PLANNER_3D_MOTION_CACHE_H
 
-#include <unordered_map>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <planner_cspace/cyclic_vec.h>
@@ -43,41 +48,97 @@ public:
   protected:
     friend class MotionCache;
 
-    std::vector<CyclicVecInt<3, 2>> motion_;
+    // Points to the pool of the MotionCache
+    const CyclicVecInt<3, 2>* motion_;
+    size_t motion_size_;
+    size_t motion_offset_;
     float distance_;
 
   public:
+    Page()
+      : motion_(nullptr)
+      , motion_size_(0)
+      , motion_offset_(0)
+      , distance_(0)
+    {
+    }
+
+    // Cells passed by the motion
+    class Motion
+    {
+    protected:
+      const CyclicVecInt<3, 2>* begin_;
+      const CyclicVecInt<3, 2>* end_;
+
+    public:
+      Motion(const CyclicVecInt<3, 2>* begin, const CyclicVecInt<3, 2>* end)
+        : begin_(begin)
+        , end_(end)
+      {
+      }
+      inline const CyclicVecInt<3, 2>* begin() const
+      {
+        return begin_;
+      }
+      inline const CyclicVecInt<3, 2>* end() const
+      {
+        return end_;
+      }
+      inline size_t size() const
+      {
+        return end_ - begin_;
+      }
+      inline const CyclicVecInt<3, 2>& operator[](const size_t i) const
+      {
+        return begin_[i];
+      }
+    };
+
     inline float getDistance() const
     {
       return distance_;
     }
-    const std::vector<CyclicVecInt<3, 2>>& getMotion() const
+    inline Motion getMotion() const
     {
-      return motion_;
+      return Motion(motion_, motion_ + motion_size_);
     }
   };
 
-  using Cache =
-      std::unordered_map<CyclicVecInt<3, 2>, Page, CyclicVecInt<3, 2>>;
+  // Pages are stored in a flat array and looked up by the dense index
+  // of the start yaw and the goal relative to the start.
+  using Cache = std::vector<std::pair<CyclicVecInt<3, 2>, Page>>;
 
   using Ptr = std::shared_ptr<MotionCache>;
 
-  inline const typename Cache::const_iterator find(
+  MotionCache()
+    : index_data_(nullptr)
+    , pool_data_(nullptr)
+    , page_size_(0)
+    , range_(0)
+    , linear_resolution_(0)
+    , angular_resolution_(0)
+    , addressor_hash_(0)
+  {
+  }
+  MotionCache(const MotionCache&) = delete;
+  MotionCache& operator=(const MotionCache&) = delete;
+
+  inline const typename Cache::value_type* find(
       const int start_yaw,
       const CyclicVecInt<3, 2>& goal) const
   {
-    int i = start_yaw % page_size_;
+    if (std::abs(goal[0]) > range_ || std::abs(goal[1]) > range_ ||
+        goal[2] < 0 || goal[2] >= page_size_)
+      return nullptr;
+    const int32_t i = index_data_[indexOf(start_yaw, goal)];
     if (i < 0)
-      i += page_size_;
-    return cache_[i].find(goal);
+      return nullptr;
+    return &cache_[i];
   }
-  inline const typename Cache::const_iterator end(
-      const int start_yaw) const
+  inline const typename Cache::value_type* end(
+      const int /* start_yaw */) const
   {
-    int i = start_yaw % page_size_;
-    if (i < 0)
-      i += page_size_;
-    return cache_[i].cend();
+    return nullptr;
   }
 
   inline const CyclicVecInt<3, 2>& getMaxRange() const
@@ -91,10 +152,47 @@ public:
       const int range,
       const std::function<void(CyclicVecInt<3, 2>, size_t&, size_t&)> gm_addr);
 
+  // Cache file stores the index and the motion pool in the binary layout of the memory
+  // and is memory-mapped on load.
+  // load() fails if the file is broken or was generated by other parameters or addressor.
+  bool load(
+      const std::string& file_name,
+      const float linear_resolution,
+      const float angular_resolution,
+      const int range,
+      const std::function<void(CyclicVecInt<3, 2>, size_t&, size_t&)> gm_addr);
+  bool save(const std::string& file_name) const;
+
 protected:
-  std::vector<Cache> cache_;
+  Cache cache_;
+  // Point to the own vectors or to the mapped cache file.
+  const int32_t* index_data_;
+  const CyclicVecInt<3, 2>* pool_data_;
+  std::vector<int32_t> index_;
+  std::vector<CyclicVecInt<3, 2>> pool_;
+  std::shared_ptr<void> mapped_file_;
   int page_size_;
+  int range_;
   CyclicVecInt<3, 2> max_range_;
+  float linear_resolution_;
+  float angular_resolution_;
+  uint64_t addressor_hash_;
+
+  static uint64_t addressorHash(
+      const int range,
+      const int angle,
+      const std::function<void(CyclicVecInt<3, 2>, size_t&, size_t&)> gm_addr);
+
+  inline size_t indexOf(const int start_yaw, const CyclicVecInt<3, 2>& goal) const
+  {
+    int yaw = start_yaw % page_size_;
+    if (yaw < 0)
+      yaw += page_size_;
+    const int width = range_ * 2 + 1;
+    return ((static_cast<size_t>(yaw) * width + (goal[0] + range_)) * width + (goal[1] + range_)) *
+               page_size_ +
+           goal[2];
+  }
 };
 
 #endif  // PLANNER_CSPACE_PLANNER_3D_MOTION_CACHE_H
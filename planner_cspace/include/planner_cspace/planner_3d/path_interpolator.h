@@ -30,7 +30,7 @@
 #ifndef PLANNER_CSPACE_PLANNER_3D_PATH_INTERPOLATOR_H
 #define PLANNER_CSPACE_PLANNER_3D_PATH_INTERPOLATOR_H
 
-#include <list>
+#include <vector>
 
 #include <planner_cspace/cyclic_vec.h>
 #include <planner_cspace/planner_3d/rotation_cache.h>
@@ -51,10 +51,12 @@ public:
     angle_ = std::lround(M_PI * 2 / angular_resolution);
     rot_cache_.reset(1.0, angular_resolution, range);
   }
-  std::list<CyclicVecFloat<3, 2>> interpolate(
-      const std::list<CyclicVecInt<3, 2>>& path_grid,
+  // Interpolated path is stored to the given buffer to reuse its memory.
+  void interpolate(
+      const std::vector<CyclicVecInt<3, 2>>& path_grid,
       const float interval,
-      const int local_range) const;
+      const int local_range,
+      std::vector<CyclicVecFloat<3, 2>>& path) const;
 };
 
 #endif  // PLANNER_CSPACE_PLANNER_3D_PATH_INTERPOLATOR_H
@@ -31,7 +31,6 @@
 #define PLANNER_CSPACE_PLANNER_3D_ROTATION_CACHE_H
 
 #include <cmath>
-#include <list>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -93,11 +92,6 @@ public:
   {
     return pages_[start_angle].radiuses(end);
   }
-
-  std::list<CyclicVecFloat<3, 2>> interpolate(
-      const std::list<CyclicVecInt<3, 2>>& path_grid,
-      const float interval,
-      const int local_range) const;
 };
 
 #endif  // PLANNER_CSPACE_PLANNER_3D_ROTATION_CACHE_H
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_PLANNER_3D_START_PREDICTION_H
+#define PLANNER_CSPACE_PLANNER_3D_START_PREDICTION_H
+
+#include <cstddef>
+#include <vector>
+
+#include <planner_cspace/cyclic_vec.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+// Poses are (x, y, yaw) in the metric coordinates.
+
+// Linear velocity of the robot moved from prev to current in dt [sec].
+// The robot is assumed to move along a circular arc tangent to its orientation,
+// so the turning motion is not underestimated by the chord length.
+float estimateLinearVelocity(
+    const CyclicVecFloat<3, 2>& prev,
+    const CyclicVecFloat<3, 2>& current,
+    const float dt);
+
+// Find the pose on the path where the robot at start will be after traveling dist along the path.
+// i_nearest is the index of the pose nearest to start and i_predicted is the index of the predicted pose.
+// Returns false if start is farther than max_dist from the path or the path ends before dist.
+bool predictPoseOnPath(
+    const std::vector<CyclicVecFloat<3, 2>>& path,
+    const CyclicVecFloat<3, 2>& start,
+    const float dist,
+    const float max_dist,
+    size_t& i_nearest,
+    size_t& i_predicted);
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+#endif  // PLANNER_CSPACE_PLANNER_3D_START_PREDICTION_H
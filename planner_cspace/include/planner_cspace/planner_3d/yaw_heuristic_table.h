@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_PLANNER_3D_YAW_HEURISTIC_TABLE_H
+#define PLANNER_CSPACE_PLANNER_3D_YAW_HEURISTIC_TABLE_H
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+#include <planner_cspace/cyclic_vec.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+// Yaw dependent lower bound of the cost to the goal in the free space.
+// The table of each goal yaw is calculated by Dijkstra on the motions without obstacles
+// from the goal placed at the origin.
+class YawHeuristicTable
+{
+public:
+  using Vec = CyclicVecInt<3, 2>;
+
+  // Lower bound of the cost of the motion.
+  // d_ is (x, y, goal yaw) in the forward list and (x, y, start yaw) in the reverse list.
+  class Motion
+  {
+  public:
+    Vec d_;
+    float cost_;
+
+    Motion(const Vec& d, const float cost)
+      : d_(d)
+      , cost_(cost)
+    {
+    }
+  };
+
+protected:
+  int angle_;
+  int range_;
+  int motion_range_;
+  float euclid_cost_lin_;
+  std::vector<std::vector<Motion>> motions_;
+  std::vector<std::vector<Motion>> motions_reverse_;
+  // Empty if not created yet.
+  std::vector<std::vector<float>> tables_;
+
+  inline bool inside(const Vec& d) const
+  {
+    return std::abs(d[0]) <= range_ && std::abs(d[1]) <= range_;
+  }
+  inline size_t index(const Vec& d) const
+  {
+    const int width = range_ * 2 + 1;
+    return (static_cast<size_t>(d[0] + range_) * width + (d[1] + range_)) * angle_ + d[2];
+  }
+
+public:
+  YawHeuristicTable();
+
+  // Table is disabled if range [cells] is not positive.
+  // motion_range [cells] is the maximum distance of the motions.
+  // euclid_cost_lin is the cost per cell used to bound the cost from the outside of the table.
+  void reset(const int angle, const int range, const int motion_range, const float euclid_cost_lin);
+  // Add the motion from start_yaw to d (x, y, goal yaw).
+  // The cost must not be larger than any cost of the motion on the map.
+  void addMotion(const int start_yaw, const Vec& d, const float cost);
+  void create(const int goal_yaw);
+
+  inline bool enabled() const
+  {
+    return range_ > 0;
+  }
+  inline bool created(const int goal_yaw) const
+  {
+    return !tables_[goal_yaw].empty();
+  }
+  // Returns the lower bound of the cost from (x, y, yaw) relative to the goal position,
+  // or 0 if unknown.
+  inline float get(const Vec& d, const int goal_yaw) const
+  {
+    if (!enabled() || !inside(d))
+      return 0;
+    const std::vector<float>& table = tables_[goal_yaw];
+    if (table.empty())
+      return 0;
+    const float cost = table[index(d)];
+    if (cost == FLT_MAX)
+      return 0;
+    return cost;
+  }
+};
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+#endif  // PLANNER_CSPACE_PLANNER_3D_YAW_HEURISTIC_TABLE_H
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_RADIX_HEAP_H
+#define PLANNER_CSPACE_RADIX_HEAP_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Monotone priority queue of the elements with float key.
+// Elements with the smallest key come first.
+// KeyOf is a functor returning the key of the element.
+//
+// Keys must not be smaller than the key of the last popped element.
+// Such keys are treated as the last popped key to keep the queue consistent,
+// so the affected elements come out earlier than their keys.
+// Call clear() before pushing the elements again with the decreased keys.
+template <class T, class KeyOf>
+class radix_heap
+{
+public:
+  typedef typename std::vector<T>::size_type size_type;
+
+  explicit radix_heap(const size_type capacity = 0)
+    : size_(0)
+    , last_(0)
+  {
+    reserve(capacity);
+  }
+  void reserve(const size_type capacity)
+  {
+    buckets_[0].reserve(capacity);
+  }
+  size_type capacity() const
+  {
+    return buckets_[0].capacity();
+  }
+  size_type size() const
+  {
+    return size_;
+  }
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+  void clear()
+  {
+    for (auto& b : buckets_)
+      b.clear();
+    size_ = 0;
+    last_ = 0;
+  }
+  const T& top()
+  {
+    pull();
+    return buckets_[0].back().second;
+  }
+  void push(const T& v)
+  {
+    insert(Element(encode(key_of_(v)), v));
+  }
+  void push(T&& v)
+  {
+    const uint32_t k = encode(key_of_(v));
+    insert(Element(k, std::move(v)));
+  }
+  template <class... Args>
+  void emplace(Args&&... args)
+  {
+    push(T(std::forward<Args>(args)...));
+  }
+  void pop()
+  {
+    pull();
+    buckets_[0].pop_back();
+    --size_;
+  }
+  // Remove the element with the largest key.
+  void pop_back()
+  {
+    for (size_t i = buckets_.size() - 1; i > 0; --i)
+    {
+      Bucket& b = buckets_[i];
+      if (b.empty())
+        continue;
+      auto it_max = b.begin();
+      for (auto it = b.begin(); it != b.end(); ++it)
+      {
+        if (it->first > it_max->first)
+          it_max = it;
+      }
+      *it_max = std::move(b.back());
+      b.pop_back();
+      --size_;
+      return;
+    }
+    // All elements have the same key.
+    buckets_[0].pop_back();
+    --size_;
+  }
+
+  // Order-preserving conversion from float to unsigned integer.
+  static uint32_t encode(const float key)
+  {
+    uint32_t u;
+    std::memcpy(&u, &key, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+  }
+
+protected:
+  using Element = std::pair<uint32_t, T>;
+  using Bucket = std::vector<Element>;
+
+  std::array<Bucket, 33> buckets_;
+  size_type size_;
+  uint32_t last_;
+  KeyOf key_of_;
+
+  static size_t bucketIndex(const uint32_t key, const uint32_t last)
+  {
+    if (key == last)
+      return 0;
+    size_t i = 0;
+    for (uint32_t x = key ^ last; x > 0; x >>= 1)
+      ++i;
+    return i;
+  }
+  void insert(Element&& e)
+  {
+    if (e.first < last_)
+      e.first = last_;
+    buckets_[bucketIndex(e.first, last_)].push_back(std::move(e));
+    ++size_;
+  }
+  // Move the elements with the smallest key to the first bucket.
+  void pull()
+  {
+    if (!buckets_[0].empty())
+      return;
+
+    size_t i = 1;
+    while (buckets_[i].empty())
+      ++i;
+
+    Bucket& b = buckets_[i];
+    uint32_t min_key = b.front().first;
+    for (const Element& e : b)
+    {
+      if (e.first < min_key)
+        min_key = e.first;
+    }
+    last_ = min_key;
+    for (Element& e : b)
+      buckets_[bucketIndex(e.first, last_)].push_back(std::move(e));
+    b.clear();
+  }
+};
+
+#endif  // PLANNER_CSPACE_RADIX_HEAP_H
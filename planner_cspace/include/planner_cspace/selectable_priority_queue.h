@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLANNER_CSPACE_SELECTABLE_PRIORITY_QUEUE_H
+#define PLANNER_CSPACE_SELECTABLE_PRIORITY_QUEUE_H
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <planner_cspace/min_max_heap.h>
+#include <planner_cspace/radix_heap.h>
+#include <planner_cspace/reservable_priority_queue.h>
+
+enum class PriorityQueueType
+{
+  BINARY_HEAP,   // pop_back() drops an arbitrary leaf
+  MIN_MAX_HEAP,  // pop_back() drops the lowest priority element
+  RADIX_HEAP,    // faster on monotone keys, pop_back() drops the lowest priority element
+};
+
+inline PriorityQueueType priorityQueueTypeFromString(const std::string& name)
+{
+  if (name == "binary_heap")
+    return PriorityQueueType::BINARY_HEAP;
+  if (name == "min_max_heap")
+    return PriorityQueueType::MIN_MAX_HEAP;
+  if (name == "radix_heap")
+    return PriorityQueueType::RADIX_HEAP;
+  throw std::invalid_argument("Unknown priority queue type: " + name);
+}
+
+// Priority queue whose implementation is selected at runtime.
+// T must be ordered by operator< as std::priority_queue and
+// KeyOf must return the float key which is smaller on the higher priority.
+template <class T, class KeyOf>
+class selectable_priority_queue
+{
+public:
+  typedef typename std::vector<T>::size_type size_type;
+
+  explicit selectable_priority_queue(
+      const PriorityQueueType type = PriorityQueueType::BINARY_HEAP)
+    : type_(type)
+  {
+  }
+  void setType(const PriorityQueueType type)
+  {
+    if (type_ == type)
+      return;
+    const size_type cap = capacity();
+    clear();
+    type_ = type;
+    reserve(cap);
+  }
+  PriorityQueueType getType() const
+  {
+    return type_;
+  }
+  void reserve(const size_type capacity)
+  {
+    switch (type_)
+    {
+      case PriorityQueueType::BINARY_HEAP:
+        return binary_.reserve(capacity);
+      case PriorityQueueType::MIN_MAX_HEAP:
+        return min_max_.reserve(capacity);
+      case PriorityQueueType::RADIX_HEAP:
+        return radix_.reserve(capacity);
+    }
+  }
+  size_type capacity() const
+  {
+    switch (type_)
+    {
+      case PriorityQueueType::BINARY_HEAP:
+        return binary_.capacity();
+      case PriorityQueueType::MIN_MAX_HEAP:
+        return min_max_.capacity();
+      case PriorityQueueType::RADIX_HEAP:
+        return radix_.capacity();
+    }
+    return 0;
+  }
+  size_type size() const
+  {
+    switch (type_)
+    {
+      case PriorityQueueType::BINARY_HEAP:
+        return binary_.size();
+      case PriorityQueueType::MIN_MAX_HEAP:
+        return min_max_.size();
+      case PriorityQueueType::RADIX_HEAP:
+        return radix_.size();
+    }
+    return 0;
+  }
+  bool empty() const
+  {
+    return size() == 0;
+  }
+  void clear()
+  {
+    binary_.clear();
+    min_max_.clear();
+    radix_.clear();
+  }
+  const T& top()
+  {
+    switch (type_)
+    {
+      case PriorityQueueType::BINARY_HEAP:
+        return binary_.top();
+      case PriorityQueueType::MIN_MAX_HEAP:
+        return min_max_.top();
+      case PriorityQueueType::RADIX_HEAP:
+        break;
+    }
+    return radix_.top();
+  }
+  void push(const T& v)
+  {
+    emplace(v);
+  }
+  void push(T&& v)
+  {
+    emplace(std::move(v));
+  }
+  template <class... Args>
+  void emplace(Args&&... args)
+  {
+    switch (type_)
+    {
+      case PriorityQueueType::BINARY_HEAP:
+        return binary_.emplace(std::forward<Args>(args)...);
+      case PriorityQueueType::MIN_MAX_HEAP:
+        return min_max_.emplace(std::forward<Args>(args)...);
+      case PriorityQueueType::RADIX_HEAP:
+        return radix_.emplace(std::forward<Args>(args)...);
+    }
+  }
+  void pop()
+  {
+    switch (type_)
+    {
+      case PriorityQueueType::BINARY_HEAP:
+        return binary_.pop();
+      case PriorityQueueType::MIN_MAX_HEAP:
+        return min_max_.pop();
+      case PriorityQueueType::RADIX_HEAP:
+        return radix_.pop();
+    }
+  }
+  void pop_back()
+  {
+    switch (type_)
+    {
+      case PriorityQueueType::BINARY_HEAP:
+        return binary_.pop_back();
+      case PriorityQueueType::MIN_MAX_HEAP:
+        return min_max_.pop_back();
+      case PriorityQueueType::RADIX_HEAP:
+        return radix_.pop_back();
+    }
+  }
+
+protected:
+  PriorityQueueType type_;
+  reservable_priority_queue<T> binary_;
+  min_max_heap<T> min_max_;
+  radix_heap<T, KeyOf> radix_;
+};
+
+#endif  // PLANNER_CSPACE_SELECTABLE_PRIORITY_QUEUE_H
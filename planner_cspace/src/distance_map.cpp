@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <ros/ros.h>
+
+#include <planner_cspace/blockmem_gridmap.h>
+#include <planner_cspace/cyclic_vec.h>
+#include <planner_cspace/planner_3d/costmap_bbf.h>
+#include <planner_cspace/planner_3d/distance_map.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+namespace
+{
+struct Update
+{
+  DistanceMap::Vec pos;
+  float cost;
+  char parent;
+};
+}  // namespace
+
+constexpr char DistanceMap::PARENT_NONE;
+
+DistanceMap::DistanceMap(const Costmap& cm_rough, const CostmapBBF& bbf)
+  : cm_rough_(cm_rough)
+  , bbf_costmap_(bbf)
+  , bucket_width_(1)
+  , bucket_num_(1)
+{
+}
+
+void DistanceMap::setParams(const Params& p)
+{
+  p_ = p;
+
+  search_diffs_.clear();
+  Vec d;
+  d[2] = 0;
+  const int range_rough = 4;
+  float cost_min = std::numeric_limits<float>::max();
+  float cost_max = 0;
+  for (d[0] = -range_rough; d[0] <= range_rough; d[0]++)
+  {
+    for (d[1] = -range_rough; d[1] <= range_rough; d[1]++)
+    {
+      if (d[0] == 0 && d[1] == 0)
+        continue;
+      if (d.sqlen() > range_rough * range_rough)
+        continue;
+
+      SearchDiffs diffs;
+
+      const int dist = d.len();
+      const float dpx = static_cast<float>(d[0]) / dist;
+      const float dpy = static_cast<float>(d[1]) / dist;
+      CyclicVecFloat<3, 2> pos(0, 0, 0);
+      for (int i = 0; i < dist; i++)
+      {
+        Vec ipos(pos);
+        if (diffs.pos.size() == 0 || diffs.pos.back() != ipos)
+        {
+          diffs.pos.push_back(std::move(ipos));
+        }
+        pos[0] += dpx;
+        pos[1] += dpy;
+      }
+      diffs.grid_to_len = d.gridToLenFactor();
+      diffs.euclid_cost = sqrtf(d[0] * d[0] + d[1] * d[1]) * p_.euclid_cost;
+      diffs.d = d;
+
+      // Costmap and remembered costs are at most 99 and 127 along the motion.
+      const float cost_upper =
+          diffs.euclid_cost +
+          (p_.resolution * diffs.grid_to_len / 100.0) * diffs.pos.size() *
+              (99 * std::abs(p_.weight_costmap) + 127 * std::abs(p_.weight_remembered));
+      cost_min = std::min(cost_min, diffs.euclid_cost);
+      cost_max = std::max(cost_max, cost_upper);
+      search_diffs_.push_back(std::move(diffs));
+    }
+  }
+
+  // Cells can't be improved by the other cells in the same bucket
+  // if the bucket is narrower than the cheapest motion.
+  bucket_width_ = std::max(cost_min, std::numeric_limits<float>::epsilon());
+  bucket_num_ = std::ceil(cost_max / bucket_width_) + 2;
+}
+
+void DistanceMap::fill(
+    Gridmap& g,
+    const std::vector<Vec>& seeds,
+    const Vec& s,
+    const float range_overshoot)
+{
+  if (state_.parents.size() != cm_rough_.size())
+    state_.parents.reset(cm_rough_.size());
+  for (const Vec& p : seeds)
+    state_.parents[p] = PARENT_NONE;
+  state_.pending.clear();
+  propagate(g, seeds, s, range_overshoot);
+}
+
+void DistanceMap::update(
+    Gridmap& g,
+    const std::vector<Region>& regions,
+    const Vec& s,
+    const float range_overshoot)
+{
+  if (state_.parents.size() != cm_rough_.size())
+  {
+    // Not filled yet.
+    return;
+  }
+  const Gridmap& g_read = g;
+  const int width = cm_rough_.size()[0];
+  const int height = cm_rough_.size()[1];
+  const int range_rough = 4;
+
+  // Motions passing through the regions start and end in the dilated regions.
+  std::vector<Region> dilated;
+  dilated.reserve(regions.size());
+  for (const Region& r : regions)
+  {
+    const Vec min(
+        std::max(r.first[0] - range_rough, 0),
+        std::max(r.first[1] - range_rough, 0),
+        0);
+    const Vec max(
+        std::min(r.second[0] + range_rough, width),
+        std::min(r.second[1] + range_rough, height),
+        0);
+    if (min[0] < max[0] && min[1] < max[1])
+      dilated.emplace_back(min, max);
+  }
+  const auto in_region = [&dilated](const Vec& p)
+  {
+    for (const Region& r : dilated)
+    {
+      if (r.first[0] <= p[0] && p[0] < r.second[0] && r.first[1] <= p[1] && p[1] < r.second[1])
+        return true;
+    }
+    return false;
+  };
+  const auto in_map = [width, height](const Vec& p)
+  {
+    return static_cast<size_t>(p[0]) < static_cast<size_t>(width) &&
+           static_cast<size_t>(p[1]) < static_cast<size_t>(height);
+  };
+  const float cost_inf = std::numeric_limits<float>::max();
+
+  // Invalidate the cells reached by the changed motions and their descendants.
+  std::vector<Vec> invalidated;
+  Vec p(0, 0, 0);
+  for (const Region& r : dilated)
+  {
+    for (p[0] = r.first[0]; p[0] < r.second[0]; p[0]++)
+    {
+      for (p[1] = r.first[1]; p[1] < r.second[1]; p[1]++)
+      {
+        const char parent = state_.parents[p];
+        if (g_read[p] == cost_inf || parent == PARENT_NONE)
+          continue;
+        if (!in_region(p - search_diffs_[parent].d))
+          continue;
+        g[p] = cost_inf;
+        invalidated.push_back(p);
+      }
+    }
+  }
+  for (size_t i = 0; i < invalidated.size(); ++i)
+  {
+    const Vec c = invalidated[i];
+    for (size_t k = 0; k < search_diffs_.size(); ++k)
+    {
+      const Vec next = c + search_diffs_[k].d;
+      if (!in_map(next) || g_read[next] == cost_inf || state_.parents[next] != static_cast<char>(k))
+        continue;
+      g[next] = cost_inf;
+      invalidated.push_back(next);
+    }
+  }
+
+  // Propagate again from the valid cells surrounding the invalidated cells,
+  // the valid cells in the regions whose motions might be cheaper,
+  // and the cells not expanded last time.
+  std::vector<Vec> seeds;
+  seeds.swap(state_.pending);
+  for (const Vec& c : invalidated)
+  {
+    for (const SearchDiffs& ds : search_diffs_)
+    {
+      const Vec next = c + ds.d;
+      if (in_map(next) && g_read[next] != cost_inf && !in_region(next))
+        seeds.push_back(next);
+    }
+  }
+  for (const Region& r : dilated)
+  {
+    for (p[0] = r.first[0]; p[0] < r.second[0]; p[0]++)
+    {
+      for (p[1] = r.first[1]; p[1] < r.second[1]; p[1]++)
+      {
+        if (g_read[p] != cost_inf)
+          seeds.push_back(p);
+      }
+    }
+  }
+  propagate(g, seeds, s, range_overshoot);
+}
+
+void DistanceMap::propagate(
+    Gridmap& g,
+    const std::vector<Vec>& seeds_in,
+    const Vec& s,
+    const float range_overshoot)
+{
+  const Gridmap& g_read = g;
+  const size_t width = cm_rough_.size()[0];
+  const size_t height = cm_rough_.size()[1];
+
+  // Seeds are put into the buckets when the propagation reaches their costs
+  // since the buckets cover only the range of one motion.
+  std::vector<std::pair<float, Vec>> seeds;
+  seeds.reserve(seeds_in.size());
+  for (const Vec& p : seeds_in)
+  {
+    if (g_read[p] != std::numeric_limits<float>::max())
+      seeds.emplace_back(g_read[p], p);
+  }
+  if (seeds.size() == 0)
+    return;
+  std::sort(
+      seeds.begin(), seeds.end(),
+      [](const std::pair<float, Vec>& a, const std::pair<float, Vec>& b)
+      {
+        return a.first < b.first;
+      });
+  const float cost_base = seeds.front().first;
+  const auto bucket_of = [this, cost_base](const float cost)
+  {
+    return static_cast<int64_t>(std::floor((cost - cost_base) / bucket_width_));
+  };
+
+  std::vector<std::vector<Vec>> buckets(bucket_num_);
+  size_t seed_pos = 0;
+  int64_t bucket = 0;
+  std::vector<Vec> frontier;
+
+#pragma omp parallel
+  {
+    std::vector<Update> updates;
+
+    while (true)
+    {
+#pragma omp barrier
+#pragma omp single
+      {
+        // Fetch the cells of the next bucket.
+        frontier.clear();
+        while (true)
+        {
+          int64_t bucket_next = -1;
+          for (size_t i = 0; i < bucket_num_; ++i)
+          {
+            if (buckets[(bucket + i) % bucket_num_].size() > 0)
+            {
+              bucket_next = bucket + i;
+              break;
+            }
+          }
+          if (seed_pos < seeds.size())
+          {
+            const int64_t bucket_seed = bucket_of(seeds[seed_pos].first);
+            if (bucket_next < 0 || bucket_seed < bucket_next)
+              bucket_next = bucket_seed;
+          }
+          if (bucket_next < 0)
+            break;
+          bucket = bucket_next;
+          if (cost_base + bucket * bucket_width_ - range_overshoot > g_read[s])
+            break;
+
+          std::vector<Vec>& cells = buckets[bucket % bucket_num_];
+          for (; seed_pos < seeds.size() && bucket_of(seeds[seed_pos].first) == bucket; ++seed_pos)
+            cells.push_back(seeds[seed_pos].second);
+          for (const Vec& p : cells)
+          {
+            // Skip the outdated entries.
+            const float gp = g_read[p];
+            if (bucket_of(gp) != bucket)
+              continue;
+            if (gp - range_overshoot > g_read[s])
+            {
+              state_.pending.push_back(p);
+              continue;
+            }
+            frontier.push_back(p);
+          }
+          cells.clear();
+          if (frontier.size() > 0)
+          {
+            std::sort(
+                frontier.begin(), frontier.end(),
+                [&g_read](const Vec& a, const Vec& b)
+                {
+                  return g_read.address(a) < g_read.address(b);
+                });
+            frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+            break;
+          }
+        }
+      }  // omp single
+
+      if (frontier.size() == 0)
+        break;
+      updates.clear();
+
+#pragma omp for schedule(static)
+      for (auto it = frontier.cbegin(); it < frontier.cend(); ++it)
+      {
+        const Vec& p = *it;
+        const float gp = g_read[p];
+
+        for (size_t k = 0; k < search_diffs_.size(); ++k)
+        {
+          const SearchDiffs& ds = search_diffs_[k];
+          const Vec next = p + ds.d;
+          if (static_cast<size_t>(next[0]) >= width ||
+              static_cast<size_t>(next[1]) >= height)
+            continue;
+
+          float cost = ds.euclid_cost;
+          const float gnext = g_read[next];
+          if (gnext < gp + cost)
+          {
+            // Skip as this motion has no chance to find better way.
+            continue;
+          }
+
+          float sum = 0, sum_hist = 0;
+          bool collision = false;
+          for (const Vec& d : ds.pos)
+          {
+            const Vec pos = p + d;
+            const char c = cm_rough_[pos];
+            if (c > 99)
+            {
+              collision = true;
+              break;
+            }
+            sum += c;
+            sum_hist += bbf_costmap_.getCost(pos);
+          }
+          if (collision)
+            continue;
+          cost +=
+              (p_.resolution * ds.grid_to_len / 100.0) *
+              (sum * p_.weight_costmap + sum_hist * p_.weight_remembered);
+          if (cost < 0)
+          {
+            cost = 0;
+            ROS_WARN_THROTTLE(1.0, "Negative cost value is detected. Limited to zero.");
+          }
+
+          const float cost_next = gp + cost;
+          if (gnext > cost_next)
+            updates.push_back(Update{next, cost_next, static_cast<char>(k)});
+        }
+      }
+#pragma omp critical
+      {
+        for (const Update& u : updates)
+        {
+          if (g[u.pos] > u.cost)
+          {
+            g[u.pos] = u.cost;
+            state_.parents[u.pos] = u.parent;
+            buckets[bucket_of(u.cost) % bucket_num_].push_back(u.pos);
+          }
+        }
+      }  // omp critical
+    }
+  }  // omp parallel
+
+  // Keep the cells not expanded to continue the propagation on the next update.
+  for (; seed_pos < seeds.size(); ++seed_pos)
+    state_.pending.push_back(seeds[seed_pos].second);
+  for (const std::vector<Vec>& cells : buckets)
+    state_.pending.insert(state_.pending.end(), cells.begin(), cells.end());
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+
+#include <planner_cspace/planner_3d/edge_cost_cache.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+constexpr int EdgeCostCache::BLOCK_BIT;
+constexpr int EdgeCostCache::BLOCK_WIDTH;
+
+EdgeCostCache::EdgeCostCache()
+  : size_(0, 0, 0)
+  , block_size_(0, 0, 0)
+  , edge_num_(0)
+  , block_mem_(0)
+  , memory_limit_(0)
+  , memory_used_(0)
+{
+}
+
+EdgeCostCache::~EdgeCostCache()
+{
+  invalidateAll();
+}
+
+void EdgeCostCache::reset(const Vec& size, const size_t edge_num, const size_t memory_limit)
+{
+  invalidateAll();
+  blocks_.reset();
+
+  size_ = size;
+  block_size_ = Vec(
+      (size[0] + BLOCK_WIDTH - 1) >> BLOCK_BIT,
+      (size[1] + BLOCK_WIDTH - 1) >> BLOCK_BIT,
+      1);
+  edge_num_ = edge_num;
+  block_mem_ = static_cast<size_t>(BLOCK_WIDTH) * BLOCK_WIDTH * size[2] * edge_num * sizeof(float);
+  memory_limit_ = memory_limit;
+  if (edge_num == 0 || block_mem_ > memory_limit)
+    return;
+
+  const size_t block_num = static_cast<size_t>(block_size_[0]) * block_size_[1];
+  blocks_.reset(new std::atomic<std::atomic<float>*>[block_num]);
+  for (size_t i = 0; i < block_num; ++i)
+    blocks_[i].store(nullptr);
+}
+
+std::atomic<float>* EdgeCostCache::allocate(const size_t baddr)
+{
+  if (memory_used_.fetch_add(block_mem_) + block_mem_ > memory_limit_)
+  {
+    memory_used_.fetch_sub(block_mem_);
+    return nullptr;
+  }
+  const size_t num = block_mem_ / sizeof(float);
+  std::atomic<float>* block = new std::atomic<float>[num];
+  for (size_t i = 0; i < num; ++i)
+    block[i].store(std::numeric_limits<float>::quiet_NaN(), std::memory_order_relaxed);
+
+  std::atomic<float>* expected = nullptr;
+  if (!blocks_[baddr].compare_exchange_strong(expected, block, std::memory_order_acq_rel))
+  {
+    // Allocated by the other thread.
+    delete[] block;
+    memory_used_.fetch_sub(block_mem_);
+    return expected;
+  }
+  return block;
+}
+
+void EdgeCostCache::release(const size_t baddr)
+{
+  std::atomic<float>* block = blocks_[baddr].exchange(nullptr);
+  if (block == nullptr)
+    return;
+  delete[] block;
+  memory_used_.fetch_sub(block_mem_);
+}
+
+void EdgeCostCache::invalidate(const Vec& min, const Vec& max)
+{
+  if (!enabled())
+    return;
+  int bmin[2];
+  int bmax[2];
+  for (int i = 0; i < 2; ++i)
+  {
+    const int lo = std::max(min[i], 0);
+    const int hi = std::min(max[i], size_[i]);
+    if (lo >= hi)
+      return;
+    bmin[i] = lo >> BLOCK_BIT;
+    bmax[i] = (hi - 1) >> BLOCK_BIT;
+  }
+  for (int by = bmin[1]; by <= bmax[1]; ++by)
+  {
+    for (int bx = bmin[0]; bx <= bmax[0]; ++bx)
+    {
+      release(static_cast<size_t>(by) * block_size_[0] + bx);
+    }
+  }
+}
+
+void EdgeCostCache::invalidateAll()
+{
+  if (!enabled())
+    return;
+  const size_t block_num = static_cast<size_t>(block_size_[0]) * block_size_[1];
+  for (size_t i = 0; i < block_num; ++i)
+    release(i);
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
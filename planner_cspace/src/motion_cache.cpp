@@ -27,8 +27,16 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
-#include <unordered_map>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include <planner_cspace/cyclic_vec.h>
@@ -42,11 +50,20 @@ void MotionCache::reset(
 {
   const int angle = std::lround(M_PI * 2 / angular_resolution);
 
-  CyclicVecInt<3, 2> max_range(0, 0, 0);
-  page_size_ = angle;
-  cache_.resize(angle);
+  struct PageTmp
+  {
+    CyclicVecInt<3, 2> goal;
+    std::vector<CyclicVecInt<3, 2>> motion;
+    float distance;
+  };
+  std::vector<std::vector<PageTmp>> pages(angle);
+  std::vector<CyclicVecInt<3, 2>> max_ranges(angle, CyclicVecInt<3, 2>(0, 0, 0));
+
+  // Pages of each start yaw are independent.
+#pragma omp parallel for schedule(dynamic)
   for (int syaw = 0; syaw < angle; syaw++)
   {
+    CyclicVecInt<3, 2>& max_range = max_ranges[syaw];
     const float yaw = syaw * angular_resolution;
     CyclicVecInt<3, 2> d;
     for (d[0] = -range; d[0] <= range; d[0]++)
@@ -59,7 +76,10 @@ void MotionCache::reset(
           continue;
         for (d[2] = 0; d[2] < angle; d[2]++)
         {
-          Page page;
+          PageTmp page;
+          page.goal = d;
+          // Cells are registered with the duplicates which are removed after sorted.
+          std::vector<CyclicVecInt<3, 2>>& motion_grid = page.motion;
           const float yaw_e = d[2] * angular_resolution;
           const float diff_val[3] =
               {
@@ -67,8 +87,6 @@ void MotionCache::reset(
                 d[1] * linear_resolution,
                 d[2] * angular_resolution
               };
-          std::unordered_map<CyclicVecInt<3, 2>, bool, CyclicVecInt<3, 2>> registered;
-          registered[d] = true;
 
           CyclicVecFloat<3, 2> motion(diff_val[0], diff_val[1], diff_val[2]);
           motion.rotate(-syaw * angular_resolution);
@@ -87,16 +105,15 @@ void MotionCache::reset(
               CyclicVecInt<3, 2> pos(
                   x / linear_resolution, y / linear_resolution, yaw / angular_resolution);
               pos.cycleUnsigned(angle);
-              if (registered.find(pos) == registered.end())
+              if (pos != d)
               {
-                page.motion_.push_back(pos);
+                motion_grid.push_back(pos);
                 for (int i = 0; i < 3; ++i)
                   max_range[i] = std::max(max_range[i], std::abs(pos[i]));
-                registered[pos] = true;
               }
             }
-            page.distance_ = d.len();
-            cache_[syaw][d] = page;
+            page.distance = d.len();
+            pages[syaw].push_back(std::move(page));
             continue;
           }
 
@@ -135,37 +152,339 @@ void MotionCache::reset(
             const CyclicVecFloat<3, 2> posf(posf_raw[0], posf_raw[1], posf_raw[2]);
             CyclicVecInt<3, 2> pos(posf_raw[0], posf_raw[1], posf_raw[2]);
             pos.cycleUnsigned(angle);
-            if (registered.find(pos) == registered.end())
-            {
-              page.motion_.push_back(pos);
-              registered[pos] = true;
-            }
+            if (pos != d)
+              motion_grid.push_back(pos);
             distf += (posf - posf_prev).len();
             posf_prev = posf;
           }
           distf += (CyclicVecFloat<3, 2>(d) - posf_prev).len();
-          page.distance_ = distf;
-          cache_[syaw][d] = page;
+          page.distance = distf;
+          pages[syaw].push_back(std::move(page));
         }
       }
     }
-    // Sort to improve cache hit rate
-    for (auto& cache : cache_[syaw])
+
+    // Sort to improve cache hit rate and remove duplicated cells.
+    // Addresses are calculated once per cell.
+    struct AddressedCell
     {
-      auto comp = [this, &gm_addr](const CyclicVecInt<3, 2> a, const CyclicVecInt<3, 2> b)
+      size_t baddr;
+      size_t addr;
+      CyclicVecInt<3, 2> pos;
+
+      bool operator<(const AddressedCell& b) const
       {
-        size_t a_baddr, a_addr;
-        size_t b_baddr, b_addr;
-        gm_addr(a, a_baddr, a_addr);
-        gm_addr(b, b_baddr, b_addr);
-        if (a_baddr == b_baddr)
+        if (baddr != b.baddr)
+          return baddr < b.baddr;
+        if (addr != b.addr)
+          return addr < b.addr;
+        for (int i = 0; i < 3; ++i)
         {
-          return (a_addr < b_addr);
+          if (pos[i] != b.pos[i])
+            return pos[i] < b.pos[i];
         }
-        return (a_baddr < b_baddr);
-      };
-      std::sort(cache.second.motion_.begin(), cache.second.motion_.end(), comp);
+        return false;
+      }
+    };
+    std::vector<AddressedCell> cells;
+    for (PageTmp& page : pages[syaw])
+    {
+      cells.clear();
+      for (const CyclicVecInt<3, 2>& pos : page.motion)
+      {
+        AddressedCell cell;
+        gm_addr(pos, cell.baddr, cell.addr);
+        cell.pos = pos;
+        cells.push_back(cell);
+      }
+      std::sort(cells.begin(), cells.end());
+      page.motion.clear();
+      for (const AddressedCell& cell : cells)
+      {
+        if (page.motion.size() == 0 || page.motion.back() != cell.pos)
+          page.motion.push_back(cell.pos);
+      }
+    }
+  }
+
+  page_size_ = angle;
+  range_ = range;
+  cache_.clear();
+  pool_.clear();
+  const int width = range * 2 + 1;
+  index_.resize(angle * width * width * angle);
+  std::fill(index_.begin(), index_.end(), -1);
+
+  // Pack the motions of all pages into one contiguous pool.
+  CyclicVecInt<3, 2> max_range(0, 0, 0);
+  size_t pool_size = 0;
+  for (int syaw = 0; syaw < angle; syaw++)
+  {
+    for (int i = 0; i < 3; ++i)
+      max_range[i] = std::max(max_range[i], max_ranges[syaw][i]);
+    for (const PageTmp& page : pages[syaw])
+      pool_size += page.motion.size();
+  }
+  pool_.reserve(pool_size);
+  for (int syaw = 0; syaw < angle; syaw++)
+  {
+    for (const PageTmp& page_tmp : pages[syaw])
+    {
+      Page page;
+      page.distance_ = page_tmp.distance;
+      page.motion_offset_ = pool_.size();
+      page.motion_size_ = page_tmp.motion.size();
+      pool_.insert(pool_.end(), page_tmp.motion.begin(), page_tmp.motion.end());
+
+      index_[indexOf(syaw, page_tmp.goal)] = cache_.size();
+      cache_.emplace_back(page_tmp.goal, page);
     }
   }
+  for (auto& page : cache_)
+    page.second.motion_ = pool_.data() + page.second.motion_offset_;
+
+  index_data_ = index_.data();
+  pool_data_ = pool_.data();
+  mapped_file_.reset();
+
   max_range_ = max_range;
+  linear_resolution_ = linear_resolution;
+  angular_resolution_ = angular_resolution;
+  addressor_hash_ = addressorHash(range, angle, gm_addr);
+}
+
+namespace
+{
+const char CACHE_FILE_MAGIC[8] = "MTNCACH";
+const uint32_t CACHE_FILE_VERSION = 1;
+
+struct CacheFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  float linear_resolution;
+  float angular_resolution;
+  int32_t range;
+  int32_t angle;
+  int32_t max_range[3];
+  uint64_t addressor_hash;
+  uint64_t index_size;
+  uint64_t page_num;
+  uint64_t pool_size;
+  uint64_t payload_hash;
+};
+struct CacheFilePage
+{
+  int32_t goal[3];
+  uint32_t motion_offset;
+  uint32_t motion_size;
+  float distance;
+};
+static_assert(
+    std::is_trivially_copyable<CyclicVecInt<3, 2>>::value &&
+        sizeof(CyclicVecInt<3, 2>) == sizeof(int32_t) * 3,
+    "CyclicVecInt<3, 2> must be stored as raw int array in the cache file");
+static_assert(
+    sizeof(CacheFileHeader) % sizeof(uint64_t) == 0 &&
+        sizeof(CacheFilePage) % sizeof(uint32_t) == 0,
+    "Cache file sections must be aligned");
+
+// FNV-1a over 32-bit words. All sections consist of 32-bit values.
+class CacheFileHash
+{
+public:
+  CacheFileHash()
+    : hash_(0xcbf29ce484222325ull)
+  {
+  }
+  void add(const uint32_t word)
+  {
+    hash_ ^= word;
+    hash_ *= 0x100000001b3ull;
+  }
+  void add(const void* data, const size_t size)
+  {
+    const uint32_t* words = reinterpret_cast<const uint32_t*>(data);
+    for (size_t i = 0; i < size / sizeof(uint32_t); ++i)
+      add(words[i]);
+  }
+  uint64_t get() const
+  {
+    return hash_;
+  }
+
+private:
+  uint64_t hash_;
+};
+}  // namespace
+
+uint64_t MotionCache::addressorHash(
+    const int range,
+    const int angle,
+    const std::function<void(CyclicVecInt<3, 2>, size_t&, size_t&)> gm_addr)
+{
+  // Order of the cells in the pages depends on the addressor of the map.
+  // Corners of the search range are enough to detect the change of the map and block size.
+  CacheFileHash hash;
+  CyclicVecInt<3, 2> d;
+  for (d[0] = -range; d[0] <= range; d[0] += std::max(range, 1))
+  {
+    for (d[1] = -range; d[1] <= range; d[1] += std::max(range, 1))
+    {
+      for (d[2] = 0; d[2] < angle; d[2] += std::max(angle - 1, 1))
+      {
+        size_t baddr, addr;
+        gm_addr(d, baddr, addr);
+        hash.add(static_cast<uint32_t>(baddr));
+        hash.add(static_cast<uint32_t>(addr));
+      }
+    }
+  }
+  return hash.get();
+}
+
+bool MotionCache::save(const std::string& file_name) const
+{
+  CacheFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+  header.version = CACHE_FILE_VERSION;
+  header.linear_resolution = linear_resolution_;
+  header.angular_resolution = angular_resolution_;
+  header.range = range_;
+  header.angle = page_size_;
+  for (int i = 0; i < 3; ++i)
+    header.max_range[i] = max_range_[i];
+  header.addressor_hash = addressor_hash_;
+  const int width = range_ * 2 + 1;
+  header.index_size = static_cast<uint64_t>(page_size_) * width * width * page_size_;
+  header.page_num = cache_.size();
+  header.pool_size = 0;
+
+  std::vector<CacheFilePage> pages;
+  pages.reserve(cache_.size());
+  for (const Cache::value_type& page : cache_)
+  {
+    CacheFilePage p;
+    for (int i = 0; i < 3; ++i)
+      p.goal[i] = page.first[i];
+    p.motion_offset = page.second.motion_offset_;
+    p.motion_size = page.second.motion_size_;
+    p.distance = page.second.distance_;
+    pages.push_back(p);
+    header.pool_size = std::max<uint64_t>(header.pool_size, p.motion_offset + p.motion_size);
+  }
+
+  CacheFileHash hash;
+  hash.add(index_data_, sizeof(int32_t) * header.index_size);
+  hash.add(pages.data(), sizeof(CacheFilePage) * pages.size());
+  hash.add(pool_data_, sizeof(CyclicVecInt<3, 2>) * header.pool_size);
+  header.payload_hash = hash.get();
+
+  // Write to a temporary file and rename to avoid leaving a partially written file.
+  const std::string tmp_name = file_name + "." + std::to_string(getpid()) + ".tmp";
+  FILE* fp = fopen(tmp_name.c_str(), "wb");
+  if (!fp)
+    return false;
+  const bool written =
+      fwrite(&header, sizeof(header), 1, fp) == 1 &&
+      fwrite(index_data_, sizeof(int32_t), header.index_size, fp) == header.index_size &&
+      fwrite(pages.data(), sizeof(CacheFilePage), pages.size(), fp) == pages.size() &&
+      fwrite(pool_data_, sizeof(CyclicVecInt<3, 2>), header.pool_size, fp) == header.pool_size;
+  if (fclose(fp) != 0 || !written || rename(tmp_name.c_str(), file_name.c_str()) != 0)
+  {
+    unlink(tmp_name.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool MotionCache::load(
+    const std::string& file_name,
+    const float linear_resolution,
+    const float angular_resolution,
+    const int range,
+    const std::function<void(CyclicVecInt<3, 2>, size_t&, size_t&)> gm_addr)
+{
+  const int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CacheFileHeader))
+  {
+    close(fd);
+    return false;
+  }
+  const size_t file_size = st.st_size;
+  void* addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    return false;
+  std::shared_ptr<void> mapped(
+      addr,
+      [file_size](void* p)
+      {
+        munmap(p, file_size);
+      });
+
+  const char* data = static_cast<const char*>(addr);
+  const CacheFileHeader& header = *reinterpret_cast<const CacheFileHeader*>(data);
+  const int angle = std::lround(M_PI * 2 / angular_resolution);
+  const int width = range * 2 + 1;
+  if (std::memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != CACHE_FILE_VERSION ||
+      header.linear_resolution != linear_resolution ||
+      header.angular_resolution != angular_resolution ||
+      header.range != range ||
+      header.angle != angle ||
+      header.addressor_hash != addressorHash(range, angle, gm_addr) ||
+      header.index_size != static_cast<uint64_t>(angle) * width * width * angle)
+    return false;
+
+  const size_t index_offset = sizeof(CacheFileHeader);
+  const size_t page_offset = index_offset + sizeof(int32_t) * header.index_size;
+  const size_t pool_offset = page_offset + sizeof(CacheFilePage) * header.page_num;
+  if (file_size != pool_offset + sizeof(CyclicVecInt<3, 2>) * header.pool_size)
+    return false;
+
+  CacheFileHash hash;
+  hash.add(data + index_offset, file_size - index_offset);
+  if (hash.get() != header.payload_hash)
+    return false;
+
+  const int32_t* index = reinterpret_cast<const int32_t*>(data + index_offset);
+  const CacheFilePage* pages = reinterpret_cast<const CacheFilePage*>(data + page_offset);
+  const CyclicVecInt<3, 2>* pool = reinterpret_cast<const CyclicVecInt<3, 2>*>(data + pool_offset);
+
+  Cache cache;
+  cache.reserve(header.page_num);
+  for (size_t i = 0; i < header.page_num; ++i)
+  {
+    const CacheFilePage& p = pages[i];
+    if (static_cast<uint64_t>(p.motion_offset) + p.motion_size > header.pool_size)
+      return false;
+    Page page;
+    page.motion_ = pool + p.motion_offset;
+    page.motion_offset_ = p.motion_offset;
+    page.motion_size_ = p.motion_size;
+    page.distance_ = p.distance;
+    cache.emplace_back(CyclicVecInt<3, 2>(p.goal[0], p.goal[1], p.goal[2]), page);
+  }
+
+  cache_.swap(cache);
+  index_.clear();
+  index_.shrink_to_fit();
+  pool_.clear();
+  pool_.shrink_to_fit();
+  index_data_ = index;
+  pool_data_ = pool;
+  mapped_file_ = mapped;
+
+  page_size_ = angle;
+  range_ = range;
+  max_range_ = CyclicVecInt<3, 2>(header.max_range[0], header.max_range[1], header.max_range[2]);
+  linear_resolution_ = linear_resolution;
+  angular_resolution_ = angular_resolution;
+  addressor_hash_ = header.addressor_hash;
+  return true;
 }
@@ -27,21 +27,22 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <list>
+#include <vector>
 
 #include <planner_cspace/cyclic_vec.h>
 #include <planner_cspace/planner_3d/rotation_cache.h>
 #include <planner_cspace/planner_3d/path_interpolator.h>
 
-std::list<CyclicVecFloat<3, 2>> PathInterpolator::interpolate(
-    const std::list<CyclicVecInt<3, 2>>& path_grid,
+void PathInterpolator::interpolate(
+    const std::vector<CyclicVecInt<3, 2>>& path_grid,
     const float interval,
-    const int local_range) const
+    const int local_range,
+    std::vector<CyclicVecFloat<3, 2>>& path) const
 {
   CyclicVecInt<3, 2> p_prev(0, 0, 0);
   bool init = false;
 
-  std::list<CyclicVecFloat<3, 2>> path;
+  path.clear();
 
   for (auto p : path_grid)
   {
@@ -107,5 +108,4 @@ std::list<CyclicVecFloat<3, 2>> PathInterpolator::interpolate(
     init = true;
   }
   path.push_back(CyclicVecFloat<3, 2>(path_grid.back()));
-  return path;
 }
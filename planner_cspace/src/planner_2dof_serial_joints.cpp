@@ -36,7 +36,6 @@
 #include <utility>
 #include <algorithm>
 #include <string>
-#include <list>
 #include <vector>
 
 #include <planner_cspace/grid_astar.h>
@@ -250,7 +249,7 @@ private:
              traj_prev.points[0].positions[id[1]]);
 
     ROS_INFO("Start searching");
-    std::list<Astar::Vecf> path;
+    std::vector<Astar::Vecf> path;
     if (makePlan(start, end, path))
     {
       ROS_INFO("Trajectory found");
@@ -545,7 +544,7 @@ private:
   {
     metric2Grid(t[0], t[1], gt[0], gt[1]);
   }
-  bool makePlan(const Astar::Vecf sg, const Astar::Vecf eg, std::list<Astar::Vecf>& path)
+  bool makePlan(const Astar::Vecf sg, const Astar::Vecf eg, std::vector<Astar::Vecf>& path)
   {
     Astar::Vec s, e;
     metric2Grid(s, sg);
@@ -578,23 +577,35 @@ private:
       }
       return true;
     }
-    std::list<Astar::Vec> path_grid;
+    std::vector<Astar::Vec> path_grid;
     // const auto ts = std::chrono::high_resolution_clock::now();
     float cancel = FLT_MAX;
     if (replan_interval_ >= ros::Duration(0))
       cancel = replan_interval_.toSec();
+    const auto cb_cost = [this](
+        const Astar::Vec& s, const Astar::Vec& e,
+        const Astar::Vec& v_start, const Astar::Vec& v_goal) -> float
+    {
+      return cbCost(s, e, v_start, v_goal);
+    };
+    const auto cb_cost_estim = [this](
+        const Astar::Vec& s, const Astar::Vec& e) -> float
+    {
+      return cbCostEstim(s, e);
+    };
+    const auto cb_search = [this](
+        const Astar::Vec& p,
+        const Astar::Vec& ss, const Astar::Vec& es) -> std::vector<Astar::Vec>&
+    {
+      return cbSearch(p, ss, es);
+    };
+    const auto cb_progress = [this](const std::vector<Astar::Vec>& path_grid)
+    {
+      return cbProgress(path_grid);
+    };
     if (!as_.search(
             s, e, path_grid,
-            std::bind(&planner2dofSerialJointsNode::cbCost,
-                      this, std::placeholders::_1, std::placeholders::_2,
-                      std::placeholders::_3, std::placeholders::_4),
-            std::bind(&planner2dofSerialJointsNode::cbCostEstim,
-                      this, std::placeholders::_1, std::placeholders::_2),
-            std::bind(&planner2dofSerialJointsNode::cbSearch,
-                      this, std::placeholders::_1,
-                      std::placeholders::_2, std::placeholders::_3),
-            std::bind(&planner2dofSerialJointsNode::cbProgress,
-                      this, std::placeholders::_1),
+            cb_cost, cb_cost_estim, cb_search, cb_progress,
             0,
             cancel,
             true))
@@ -674,7 +685,7 @@ private:
   {
     return search_list_;
   }
-  bool cbProgress(const std::list<Astar::Vec>& path_grid)
+  bool cbProgress(const std::vector<Astar::Vec>& path_grid)
   {
     return false;
   }
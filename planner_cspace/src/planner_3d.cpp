@@ -28,13 +28,20 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <functional>
 #include <limits>
 #include <list>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
 
 #include <costmap_cspace_msgs/CSpace3D.h>
 #include <costmap_cspace_msgs/CSpace3DUpdate.h>
@@ -62,11 +69,17 @@
 #include <planner_cspace/bbf.h>
 #include <planner_cspace/grid_astar.h>
 #include <planner_cspace/planner_3d/costmap_bbf.h>
+#include <planner_cspace/planner_3d/costmap_update.h>
+#include <planner_cspace/planner_3d/distance_map.h>
+#include <planner_cspace/planner_3d/edge_cost_cache.h>
 #include <planner_cspace/planner_3d/grid_metric_converter.h>
 #include <planner_cspace/planner_3d/jump_detector.h>
+#include <planner_cspace/planner_3d/lethal_mask.h>
 #include <planner_cspace/planner_3d/motion_cache.h>
 #include <planner_cspace/planner_3d/path_interpolator.h>
 #include <planner_cspace/planner_3d/rotation_cache.h>
+#include <planner_cspace/planner_3d/start_prediction.h>
+#include <planner_cspace/planner_3d/yaw_heuristic_table.h>
 
 #include <omp.h>
 
@@ -84,6 +97,29 @@ protected:
 
   ros::NodeHandle nh_;
   ros::NodeHandle pnh_;
+  // Messages changing the planning state are received in the other thread
+  // not to be blocked by the search, and processed between the searches.
+  ros::CallbackQueue queue_receive_;
+  ros::NodeHandle nh_receive_;
+  ros::NodeHandle pnh_receive_;
+  std::mutex pending_mtx_;
+  enum class PendingType
+  {
+    MAP,
+    MAP_UPDATE,
+    GOAL,
+    ACTION,
+  };
+  struct PendingCallback
+  {
+    PendingType type;
+    std::function<void()> cb;
+  };
+  std::vector<PendingCallback> pending_callbacks_;
+  // False during the search requested by the make_plan service.
+  // The messages received during it are processed after the search without canceling it.
+  std::atomic<bool> search_cancelable_;
+  ros::AsyncSpinner spinner_receive_;
   ros::Subscriber sub_map_;
   ros::Subscriber sub_map_update_;
   ros::Subscriber sub_goal_;
@@ -104,14 +140,36 @@ protected:
   tf2_ros::TransformListener tfl_;
 
   Astar as_;
-  Astar::Gridmap<char, 0x40> cm_;
-  Astar::Gridmap<char, 0x80> cm_rough_;
+  Astar::OverlayGridmap<char, 0x40> cm_;
+  Astar::OverlayGridmap<char, 0x80> cm_rough_;
   Astar::Gridmap<char, 0x40> cm_base_;
   Astar::Gridmap<char, 0x80> cm_rough_base_;
   Astar::Gridmap<char, 0x80> cm_hyst_;
+  // Hysteresis map being generated to be compared with cm_hyst_.
+  // Only the cells around the last generated path are valid.
+  Astar::Gridmap<char, 0x80> cm_hyst_next_;
   Astar::Gridmap<char, 0x80> cm_updates_;
-  Astar::Gridmap<float> cost_estim_cache_;
+  LethalMask lethal_mask_;
+  Astar::EpochGridmap<float> cost_estim_cache_;
   CostmapBBF bbf_costmap_;
+  DistanceMap distance_map_;
+  EdgeCostCache edge_cost_cache_;
+  int edge_cost_cache_memory_mb_;
+
+  struct CostEstimCacheEntry
+  {
+    Astar::Vec goal;
+    Astar::EpochGridmap<float> g;
+    DistanceMap::State state;
+    // Areas of the costmap changed after the field is stored.
+    std::vector<DistanceMap::Region> changed;
+  };
+  // Fields of the recent goals to be reused on the recurring goals, most recently used first.
+  std::list<CostEstimCacheEntry> cost_estim_cache_pool_;
+  size_t cost_estim_cache_pool_size_;
+  int goal_cache_memory_mb_;
+  Astar::Vec cost_estim_cache_goal_;
+  bool has_cost_estim_cache_;
 
   std::array<float, 1024> euclid_cost_lin_cache_;
 
@@ -142,6 +200,202 @@ protected:
     return cost;
   }
 
+  // Motion from a start yaw with the costs independent of the map.
+  class MotionPrimitive
+  {
+  public:
+    enum Type
+    {
+      INVALID,
+      IN_PLACE_TURN,
+      STRAIGHT,
+      CURVE,
+    };
+    Type type_;
+    const MotionCache::Page* page_;
+    // Cells of the motion to reject the collided motion at first.
+    LethalMask::Footprint footprint_;
+    float cost_;
+    // Factors of the sums of the costmap and the hysteresis map along the motion
+    float weight_costmap_;
+    float weight_hysteresis_;
+    // Index in the search list of the start yaw
+    size_t index_;
+
+    MotionPrimitive()
+      : type_(INVALID)
+      , page_(nullptr)
+      , cost_(0)
+      , weight_costmap_(0)
+      , weight_hysteresis_(0)
+      , index_(0)
+    {
+    }
+  };
+  std::vector<MotionPrimitive> motion_primitives_;
+  std::vector<std::vector<Astar::Vec>> search_list_yaw_;
+  std::vector<std::vector<Astar::Vec>> search_list_rough_yaw_;
+
+  YawHeuristicTable yaw_heuristic_table_;
+  double yaw_heuristic_range_f_;
+
+  size_t motionPrimitiveIndex(const int start_yaw, const Astar::Vec& d, const int goal_yaw) const
+  {
+    const int width = range_ * 2 + 1;
+    return ((static_cast<size_t>(start_yaw) * width + (d[0] + range_)) * width + (d[1] + range_)) *
+               map_info_.angle +
+           goal_yaw;
+  }
+  MotionPrimitive createMotionPrimitive(const int start_yaw, const Astar::Vec& d) const
+  {
+    MotionPrimitive prim;
+    if (d[0] == 0 && d[1] == 0)
+    {
+      if (d[2] != 0)
+        prim.type_ = MotionPrimitive::IN_PLACE_TURN;
+      return prim;
+    }
+
+    Astar::Vec d2;
+    d2[0] = d[0] + range_;
+    d2[1] = d[1] + range_;
+    d2[2] = (start_yaw + d[2] + map_info_.angle) % map_info_.angle;
+
+    const Astar::Vecf motion = rot_cache_.getMotion(start_yaw, d2);
+    const Astar::Vecf resolution(
+        1.0f / map_info_.linear_resolution, 1.0f / map_info_.linear_resolution, 1.0f / map_info_.angular_resolution);
+    const Astar::Vecf motion_grid = motion * resolution;
+
+    if (lroundf(motion_grid[0]) == 0 && lroundf(motion_grid[1]) != 0)
+    {
+      // Not non-holonomic
+      return prim;
+    }
+
+    if (fabs(motion[2]) >= 2.0 * M_PI / 4.0)
+    {
+      // Over 90 degree turn
+      // must be separated into two curves
+      return prim;
+    }
+
+    const float dist = motion.len();
+    float cost = euclidCostRough(d) + fabs(ec_[2] * d[2]);
+
+    if (motion[0] < 0)
+    {
+      // Going backward
+      cost *= 1.0 + cc_.weight_backward_;
+    }
+
+    Astar::Vec d_index(d[0], d[1], d2[2]);
+    const auto cache_page = motion_cache_.find(start_yaw, d_index);
+    if (cache_page == motion_cache_.end(start_yaw))
+      return prim;
+    const int num = cache_page->second.getMotion().size();
+    const float distf = cache_page->second.getDistance();
+
+    if (d[2] == 0)
+    {
+      if (lroundf(motion_grid[0]) == 0)
+        return prim;  // side slip
+      const float aspect = motion[0] / motion[1];
+      if (fabs(aspect) < angle_resolution_aspect_)
+        return prim;  // large y offset
+
+      cost += ec_[2] * fabs(1.0 / aspect) * map_info_.angular_resolution / (M_PI * 2.0);
+
+      prim.type_ = MotionPrimitive::STRAIGHT;
+      prim.weight_costmap_ =
+          map_info_.linear_resolution * distf * cc_.weight_costmap_ / (100.0 * num);
+    }
+    else
+    {
+      // Curve
+      if (motion[0] * motion[1] * motion[2] < 0)
+        return prim;
+
+      if (d.sqlen() < 3 * 3)
+        return prim;
+
+      const std::pair<float, float>& radiuses = rot_cache_.getRadiuses(start_yaw, d2);
+      const float r1 = radiuses.first;
+      const float r2 = radiuses.second;
+
+      // curveture at the start_ pose and the end pose must be same
+      if (fabs(r1 - r2) >= map_info_.linear_resolution * 1.5)
+      {
+        // Drifted
+        return prim;
+      }
+
+      const float curv_radius = (r1 + r2) / 2;
+      if (std::abs(curv_radius) < min_curve_raduis_)
+        return prim;
+
+      if (fabs(max_vel_ / r1) > max_ang_vel_)
+      {
+        const float vel = fabs(curv_radius) * max_ang_vel_;
+
+        // Curve deceleration penalty
+        cost += dist * fabs(vel / max_vel_) * cc_.weight_decel_;
+      }
+
+      prim.type_ = MotionPrimitive::CURVE;
+      prim.weight_costmap_ =
+          map_info_.linear_resolution * distf * cc_.weight_costmap_ / (100.0 * num) +
+          map_info_.angular_resolution * abs(d[2]) * cc_.weight_costmap_turn_ / (100.0 * num);
+    }
+    prim.page_ = &cache_page->second;
+    prim.footprint_ = LethalMask::createFootprint(cache_page->second.getMotion());
+    prim.cost_ = cost;
+    prim.weight_hysteresis_ =
+        map_info_.linear_resolution * distf * cc_.weight_hysteresis_ / (100.0 * num);
+    return prim;
+  }
+  void createMotionPrimitives()
+  {
+    const int width = range_ * 2 + 1;
+    motion_primitives_.clear();
+    motion_primitives_.resize(map_info_.angle * width * width * map_info_.angle);
+    search_list_yaw_.resize(map_info_.angle);
+    search_list_rough_yaw_.resize(map_info_.angle);
+    yaw_heuristic_table_.reset(
+        map_info_.angle,
+        std::lround(yaw_heuristic_range_f_ / map_info_.linear_resolution),
+        range_, ec_[0]);
+    size_t num_valid = 0;
+    for (int yaw = 0; yaw < static_cast<int>(map_info_.angle); ++yaw)
+    {
+      search_list_yaw_[yaw].clear();
+      search_list_rough_yaw_[yaw].clear();
+      for (const Astar::Vec& d : search_list_)
+      {
+        Astar::Vec d_cycled = d;
+        d_cycled.cycle(map_info_.angle);
+        MotionPrimitive prim = createMotionPrimitive(yaw, d_cycled);
+        if (prim.type_ == MotionPrimitive::INVALID)
+          continue;
+        prim.index_ = search_list_yaw_[yaw].size();
+
+        const int goal_yaw = (yaw + d_cycled[2] + map_info_.angle) % map_info_.angle;
+        motion_primitives_[motionPrimitiveIndex(yaw, d_cycled, goal_yaw)] = prim;
+        search_list_yaw_[yaw].push_back(d);
+        if (d[2] == 0)
+          search_list_rough_yaw_[yaw].push_back(d);
+        ++num_valid;
+
+        // Costs of the costmap and the hysteresis are not negative.
+        const float cost_min =
+            prim.type_ == MotionPrimitive::IN_PLACE_TURN ? cc_.in_place_turn_ : prim.cost_;
+        yaw_heuristic_table_.addMotion(yaw, Astar::Vec(d[0], d[1], goal_yaw), cost_min);
+      }
+    }
+    ROS_DEBUG("Motion primitives generated (%d/%d)",
+              static_cast<int>(num_valid),
+              static_cast<int>(search_list_.size() * map_info_.angle));
+  }
+
   RotationCache rot_cache_;
   PathInterpolator path_interpolator_;
 
@@ -174,6 +428,18 @@ protected:
   bool goal_updated_;
   bool remember_updates_;
   bool fast_map_update_;
+  bool incremental_search_;
+  Astar::Vec update_min_prev_;
+  Astar::Vec update_max_prev_;
+  bool has_update_prev_;
+  bool hyst_prev_;
+  std::vector<Astar::Vec> hyst_path_grid_;
+  // Region [min, max) containing all cells of cm_hyst_ lower than 100.
+  Astar::Vec hyst_min_;
+  Astar::Vec hyst_max_;
+  // Buffers of the planned path reused across the plannings.
+  std::vector<Astar::Vec> path_grid_;
+  std::vector<Astar::Vecf> path_interpolated_;
   std::vector<Astar::Vec> search_list_;
   std::vector<Astar::Vec> search_list_rough_;
   double hist_ignore_range_f_;
@@ -193,7 +459,7 @@ protected:
   int max_retry_num_;
 
   int num_task_;
-  int num_cost_estim_task_;
+  PriorityQueueType open_list_type_;
 
   // Cost weights
   class CostCoeff
@@ -213,6 +479,16 @@ protected:
   CostCoeff cc_;
 
   geometry_msgs::PoseStamped start_;
+  // Start pose of the previous cycle to estimate the speed of the robot.
+  geometry_msgs::PoseStamped start_prev_;
+  bool has_start_prev_;
+  float start_vel_;
+  bool compensate_latency_;
+  // Smoothed duration from the start of the planning to the publish of the path.
+  float plan_latency_;
+  // Weight of the latest latency in the exponential moving average.
+  float latency_smoothing_factor_;
+  nav_msgs::Path path_prev_;
   geometry_msgs::PoseStamped goal_;
   geometry_msgs::PoseStamped goal_raw_;
   Astar::Vecf ec_;
@@ -229,8 +505,10 @@ protected:
   bool find_best_;
   float sw_wait_;
 
-  float rough_cost_max_;
-  bool rough_;
+  // Starts of the running search. Read by the callbacks called from the search threads.
+  std::vector<Astar::VecWithCost> search_starts_;
+  // True if the last makePlan() was returned by the cancellation of the search.
+  bool plan_canceled_;
 
   bool force_goal_orientation_;
 
@@ -240,6 +518,7 @@ protected:
 
   MotionCache motion_cache_;
   MotionCache motion_cache_linear_;
+  std::string motion_cache_dir_;
   Astar::Vec min_boundary_;
   Astar::Vec max_boundary_;
 
@@ -253,6 +532,8 @@ protected:
     ROS_WARN("Forgetting remembered costmap.");
     if (has_map_)
       bbf_costmap_.clear();
+    // Remembered costs stored in the fields are no longer valid.
+    cost_estim_cache_pool_.clear();
 
     return true;
   }
@@ -334,7 +615,7 @@ protected:
     {
       return search_list_rough_;
     };
-    const auto cb_progress = [](const std::list<Astar::Vec>& path_grid)
+    const auto cb_progress = [](const std::vector<Astar::Vec>& path_grid)
     {
       return true;
     };
@@ -342,12 +623,24 @@ protected:
     const auto ts = boost::chrono::high_resolution_clock::now();
     // ROS_INFO("Planning from (%d, %d, %d) to (%d, %d, %d)",
     //   s[0], s[1], s[2], e[0], e[1], e[2]);
-    std::list<Astar::Vec> path_grid;
-    if (!as_.search(s, e, path_grid,
-                    cb_cost, cb_cost_estim, cb_search, cb_progress,
-                    0,
-                    1.0f / freq_min_,
-                    find_best_))
+    std::vector<Astar::Vec> path_grid;
+    {
+      // Cancel requests after this are not applied to the search requested by the service.
+      std::lock_guard<std::mutex> lock(pending_mtx_);
+      search_cancelable_ = false;
+      as_.resetCancel();
+    }
+    // The search tree can't be reused since the cost functions are different.
+    as_.invalidateAll();
+    const bool found = as_.search(
+        s, e, path_grid,
+        cb_cost, cb_cost_estim, cb_search, cb_progress,
+        0,
+        1.0f / freq_min_,
+        find_best_);
+    as_.invalidateAll();
+    search_cancelable_ = true;
+    if (!found)
     {
       ROS_WARN("Path plan failed (goal unreachable)");
       return false;
@@ -360,8 +653,8 @@ protected:
     path.header = map_header_;
     path.header.stamp = ros::Time::now();
 
-    const std::list<Astar::Vecf> path_interpolated =
-        path_interpolator_.interpolate(path_grid, 0.5, 0.0);
+    std::vector<Astar::Vecf> path_interpolated;
+    path_interpolator_.interpolate(path_grid, 0.5, 0.0, path_interpolated);
     grid_metric_converter::grid2MetricPath(map_info_, path_interpolated, path);
 
     res.plan.header = map_header_;
@@ -383,6 +676,79 @@ protected:
     }
     setGoal(*msg);
   }
+  void deferCallback(const PendingType type, const std::function<void()>& cb, const bool cancel_search)
+  {
+    std::lock_guard<std::mutex> lock(pending_mtx_);
+    if (type == PendingType::MAP_UPDATE || type == PendingType::GOAL)
+    {
+      // Only the latest map update and goal are meaningful
+      // since the map update overwrites the previous one and so does the goal.
+      pending_callbacks_.erase(
+          std::remove_if(
+              pending_callbacks_.begin(), pending_callbacks_.end(),
+              [type](const PendingCallback& c)
+              {
+                return c.type == type;
+              }),
+          pending_callbacks_.end());
+    }
+    pending_callbacks_.push_back(PendingCallback{type, cb});
+    if (cancel_search && search_cancelable_)
+      as_.cancel();
+  }
+  void processPendingCallbacks()
+  {
+    std::vector<PendingCallback> callbacks;
+    {
+      std::lock_guard<std::mutex> lock(pending_mtx_);
+      as_.resetCancel();
+      callbacks.swap(pending_callbacks_);
+    }
+    for (const PendingCallback& c : callbacks)
+      c.cb();
+  }
+  void cbMapReceived(const costmap_cspace_msgs::CSpace3D::ConstPtr& msg)
+  {
+    const auto cb = [this, msg]()
+    {
+      cbMap(msg);
+    };
+    deferCallback(PendingType::MAP, cb, true);
+  }
+  void cbMapUpdateReceived(const costmap_cspace_msgs::CSpace3DUpdate::ConstPtr& msg)
+  {
+    const auto cb = [this, msg]()
+    {
+      cbMapUpdate(msg);
+    };
+    deferCallback(PendingType::MAP_UPDATE, cb, false);
+  }
+  void cbGoalReceived(const geometry_msgs::PoseStamped::ConstPtr& msg)
+  {
+    const auto cb = [this, msg]()
+    {
+      cbGoal(msg);
+    };
+    deferCallback(PendingType::GOAL, cb, true);
+  }
+  void cbActionReceived()
+  {
+    const auto cb = [this]()
+    {
+      if (act_->isNewGoalAvailable())
+        cbAction();
+    };
+    deferCallback(PendingType::ACTION, cb, true);
+  }
+  void cbPreemptReceived()
+  {
+    const auto cb = [this]()
+    {
+      if (act_->isPreemptRequested())
+        cbPreempt();
+    };
+    deferCallback(PendingType::ACTION, cb, true);
+  }
   void cbPreempt()
   {
     ROS_WARN("Preempting the current goal.");
@@ -429,165 +795,97 @@ protected:
     return true;
   }
   void fillCostmap(
-      reservable_priority_queue<Astar::PriorityVec>& open,
-      Astar::Gridmap<float>& g,
+      const std::vector<Astar::Vec>& seeds,
+      Astar::EpochGridmap<float>& g,
       const Astar::Vec& s, const Astar::Vec& e)
   {
     const Astar::Vec s_rough(s[0], s[1], 0);
+    const float range_overshoot = ec_[0] * (range_ + local_range_ + longcut_range_);
+    distance_map_.fill(g, seeds, s_rough, range_overshoot);
+  }
+  void updateCostmap(
+      const std::vector<DistanceMap::Region>& changed,
+      const Astar::Vec& s)
+  {
+    const Astar::Vec s_rough(s[0], s[1], 0);
+    const float range_overshoot = ec_[0] * (range_ + local_range_ + longcut_range_);
+    distance_map_.update(cost_estim_cache_, changed, s_rough, range_overshoot);
+  }
+  void storeCostEstimCache()
+  {
+    if (!has_cost_estim_cache_ || cost_estim_cache_pool_size_ == 0)
+      return;
 
-    struct SearchDiffs
+    for (auto it = cost_estim_cache_pool_.begin(); it != cost_estim_cache_pool_.end(); ++it)
     {
-      Astar::Vec d;
-      std::vector<Astar::Vec> pos;
-      float grid_to_len;
-    };
-    std::vector<SearchDiffs> search_diffs;
-    {
-      Astar::Vec d;
-      d[2] = 0;
-      const int range_rough = 4;
-      for (d[0] = -range_rough; d[0] <= range_rough; d[0]++)
+      if (it->goal == cost_estim_cache_goal_)
       {
-        for (d[1] = -range_rough; d[1] <= range_rough; d[1]++)
-        {
-          if (d[0] == 0 && d[1] == 0)
-            continue;
-          if (d.sqlen() > range_rough * range_rough)
-            continue;
-
-          SearchDiffs diffs;
-
-          const float grid_to_len = d.gridToLenFactor();
-          const int dist = d.len();
-          const float dpx = static_cast<float>(d[0]) / dist;
-          const float dpy = static_cast<float>(d[1]) / dist;
-          Astar::Vecf pos(0, 0, 0);
-          for (int i = 0; i < dist; i++)
-          {
-            Astar::Vec ipos(pos);
-            if (diffs.pos.size() == 0 || diffs.pos.back() != ipos)
-            {
-              diffs.pos.push_back(std::move(ipos));
-            }
-            pos[0] += dpx;
-            pos[1] += dpy;
-          }
-          diffs.grid_to_len = grid_to_len;
-          diffs.d = d;
-          search_diffs.push_back(std::move(diffs));
-        }
+        cost_estim_cache_pool_.erase(it);
+        break;
       }
     }
+    if (cost_estim_cache_pool_.size() >= cost_estim_cache_pool_size_)
+      cost_estim_cache_pool_.pop_back();
 
-    std::vector<Astar::PriorityVec> centers;
-    centers.reserve(num_cost_estim_task_);
-
-#pragma omp parallel
+    cost_estim_cache_pool_.emplace_front();
+    CostEstimCacheEntry& entry = cost_estim_cache_pool_.front();
+    entry.goal = cost_estim_cache_goal_;
+    entry.g = cost_estim_cache_;
+    entry.state = distance_map_.getState();
+  }
+  bool restoreCostEstimCache(const Astar::Vec& e, const Astar::Vec& s)
+  {
+    for (auto it = cost_estim_cache_pool_.begin(); it != cost_estim_cache_pool_.end(); ++it)
     {
-      std::vector<Astar::GridmapUpdate> updates;
-      updates.reserve(num_cost_estim_task_ * search_diffs.size() / omp_get_num_threads());
-
-      const float range_overshoot = ec_[0] * (range_ + local_range_ + longcut_range_);
+      if (it->goal != e)
+        continue;
 
-      while (true)
+      cost_estim_cache_ = it->g;
+      distance_map_.setState(it->state);
+      const std::vector<DistanceMap::Region> changed = std::move(it->changed);
+      // The field is active now and will be stored again on the next goal change.
+      cost_estim_cache_pool_.erase(it);
+      // Propagation was stopped around the start at the time of storing.
+      // Resume it from the pending cells for the current start even if the costmap is not changed.
+      updateCostmap(changed, s);
+      return true;
+    }
+    return false;
+  }
+  void addCostEstimCacheChange(const Astar::Vec& changed_min, const Astar::Vec& changed_max)
+  {
+    // Merge the regions into the bounding box if the list grows
+    // to keep the cost of the repair bounded.
+    const size_t changed_num_max = 32;
+    for (CostEstimCacheEntry& entry : cost_estim_cache_pool_)
+    {
+      bool covered = false;
+      for (const DistanceMap::Region& r : entry.changed)
       {
-#pragma omp barrier
-#pragma omp single
+        if (r.first[0] <= changed_min[0] && r.first[1] <= changed_min[1] &&
+            changed_max[0] <= r.second[0] && changed_max[1] <= r.second[1])
         {
-          centers.clear();
-          for (size_t i = 0; i < static_cast<size_t>(num_cost_estim_task_);)
-          {
-            if (open.size() < 1)
-              break;
-            Astar::PriorityVec center(open.top());
-            open.pop();
-            if (center.p_raw_ > g[center.v_])
-              continue;
-            if (center.p_raw_ - range_overshoot > g[s_rough])
-              continue;
-            centers.emplace_back(std::move(center));
-            ++i;
-          }
-        }  // omp single
-
-        if (centers.size() == 0)
+          covered = true;
           break;
-        updates.clear();
-
-#pragma omp for schedule(static)
-        for (auto it = centers.cbegin(); it < centers.cend(); ++it)
-        {
-          const Astar::Vec p = it->v_;
-
-          for (const SearchDiffs& ds : search_diffs)
-          {
-            const Astar::Vec d = ds.d;
-            const Astar::Vec next = p + d;
-
-            if (static_cast<size_t>(next[0]) >= static_cast<size_t>(map_info_.width) ||
-                static_cast<size_t>(next[1]) >= static_cast<size_t>(map_info_.height))
-              continue;
-
-            float cost = euclidCostRough(d);
-
-            const float gnext = g[next];
-
-            if (gnext < g[p] + cost)
-            {
-              // Skip as this search task has no chance to find better way.
-              continue;
-            }
-
-            {
-              float sum = 0, sum_hist = 0;
-              bool collision = false;
-              for (const auto& d : ds.pos)
-              {
-                const Astar::Vec pos = p + d;
-                const char c = cm_rough_[pos];
-                if (c > 99)
-                {
-                  collision = true;
-                  break;
-                }
-                sum += c;
-                sum_hist += bbf_costmap_.getCost(pos);
-              }
-              if (collision)
-                continue;
-              cost +=
-                  (map_info_.linear_resolution * ds.grid_to_len / 100.0) *
-                  (sum * cc_.weight_costmap_ + sum_hist * cc_.weight_remembered_);
-
-              if (cost < 0)
-              {
-                cost = 0;
-                ROS_WARN_THROTTLE(1.0, "Negative cost value is detected. Limited to zero.");
-              }
-            }
-
-            const float cost_next = it->p_raw_ + cost;
-            if (gnext > cost_next)
-            {
-              updates.emplace_back(p, next, cost_next, cost_next);
-            }
-          }
         }
-#pragma omp barrier
-#pragma omp critical
+      }
+      if (covered)
+        continue;
+      entry.changed.emplace_back(changed_min, changed_max);
+      if (entry.changed.size() > changed_num_max)
+      {
+        DistanceMap::Region bbox = entry.changed.front();
+        for (const DistanceMap::Region& r : entry.changed)
         {
-          for (const Astar::GridmapUpdate& u : updates)
+          for (int i = 0; i < 2; ++i)
           {
-            if (g[u.getPos()] > u.getCost())
-            {
-              g[u.getPos()] = u.getCost();
-              open.push(std::move(u.getPriorityVec()));
-            }
+            bbox.first[i] = std::min(bbox.first[i], r.first[i]);
+            bbox.second[i] = std::max(bbox.second[i], r.second[i]);
           }
-        }  // omp critical
+        }
+        entry.changed.assign(1, bbox);
       }
-    }  // omp parallel
-    rough_cost_max_ = g[s_rough] + ec_[0] * (range_ + local_range_);
+    }
   }
   bool searchAvailablePos(Astar::Vec& s, const int xy_range, const int angle_range,
                           const int cost_acceptable = 50, const int min_xy_range = 0)
@@ -685,9 +983,9 @@ protected:
     }
 
     const auto ts = boost::chrono::high_resolution_clock::now();
-    reservable_priority_queue<Astar::PriorityVec> open;
-    open.reserve(map_info_.width * map_info_.height / 2);
-
+    if (goal_changed)
+      storeCostEstimCache();
+    has_cost_estim_cache_ = false;
     cost_estim_cache_.clear(FLT_MAX);
     if (cm_[e] == 100)
     {
@@ -715,18 +1013,31 @@ protected:
     }
 
     e[2] = 0;
-    cost_estim_cache_[e] = -ec_[0] * 0.5;  // Decrement to reduce calculation error
-    open.push(Astar::PriorityVec(cost_estim_cache_[e], cost_estim_cache_[e], e));
-    fillCostmap(open, cost_estim_cache_, s, e);
-    const auto tnow = boost::chrono::high_resolution_clock::now();
-    ROS_DEBUG("Cost estimation cache generated (%0.4f sec.)",
-              boost::chrono::duration<float>(tnow - ts).count());
-    cost_estim_cache_[e] = 0;
+    if (goal_changed && restoreCostEstimCache(e, s))
+    {
+      const auto tnow = boost::chrono::high_resolution_clock::now();
+      ROS_DEBUG("Cost estimation cache restored (%0.4f sec.)",
+                boost::chrono::duration<float>(tnow - ts).count());
+    }
+    else
+    {
+      cost_estim_cache_[e] = -ec_[0] * 0.5;  // Decrement to reduce calculation error
+      fillCostmap(std::vector<Astar::Vec>(1, e), cost_estim_cache_, s, e);
+      const auto tnow = boost::chrono::high_resolution_clock::now();
+      ROS_DEBUG("Cost estimation cache generated (%0.4f sec.)",
+                boost::chrono::duration<float>(tnow - ts).count());
+      cost_estim_cache_[e] = 0;
+    }
+    cost_estim_cache_goal_ = e;
+    has_cost_estim_cache_ = true;
 
     if (goal_changed)
     {
       cm_hyst_.clear(100);
       has_hysteresis_map_ = false;
+      hyst_path_grid_.clear();
+      as_.invalidateAll();
+      edge_cost_cache_.invalidateAll();
     }
 
     publishDebug();
@@ -825,6 +1136,7 @@ protected:
     {
       pub_path_.publish(path);
     }
+    path_prev_.poses.clear();
   }
 
   void cbMapUpdate(const costmap_cspace_msgs::CSpace3DUpdate::ConstPtr& msg)
@@ -836,52 +1148,54 @@ protected:
     const ros::Time now = ros::Time::now();
     last_costmap_ = now;
 
-    cm_ = cm_base_;
-    cm_rough_ = cm_rough_base_;
+    // Restore only the blocks overwritten by the previous update.
+    cm_.restore(cm_base_);
+    cm_rough_.restore(cm_rough_base_);
     cm_updates_.clear(-1);
 
-    bool clear_hysteresis(false);
+    std::atomic<bool> clear_hysteresis(false);
 
     {
       const Astar::Vec gp(
           static_cast<int>(msg->x), static_cast<int>(msg->y), static_cast<int>(msg->yaw));
       const Astar::Vec gp_rough(gp[0], gp[1], 0);
-      for (Astar::Vec p(0, 0, 0); p[0] < static_cast<int>(msg->width); p[0]++)
+      const Astar::Vec gp_end(
+          static_cast<int>(msg->x + msg->width), static_cast<int>(msg->y + msg->height), 0);
+      cm_.markDirty(gp_rough, gp_end);
+      cm_rough_.markDirty(gp_rough, gp_end);
+      if (has_update_prev_)
+      {
+        // Cells overwritten by the previous update are restored.
+        lethal_mask_.update(cm_, update_min_prev_, update_max_prev_);
+      }
+      const int angle = msg->angle;
+      const auto cb_column = [this, angle, &clear_hysteresis](const Astar::Vec& p, const char* costs)
       {
-        for (p[1] = 0; p[1] < static_cast<int>(msg->height); p[1]++)
+        int cost_min = 100;
+        Astar::Vec p_yaw = p;
+        for (int i = 0; i < angle; ++i, ++p_yaw[2])
         {
-          int cost_min = 100;
-          for (p[2] = 0; p[2] < static_cast<int>(msg->angle); p[2]++)
-          {
-            const size_t addr = ((p[2] * msg->height) + p[1]) * msg->width + p[0];
-            const char c = msg->data[addr];
-            if (c < cost_min)
-              cost_min = c;
-            if (c == 100 && !clear_hysteresis && cm_hyst_[gp + p] == 0)
-              clear_hysteresis = true;
-          }
-          p[2] = 0;
-          cm_updates_[gp_rough + p] = cost_min;
-          if (cost_min > cm_rough_[gp_rough + p])
-            cm_rough_[gp_rough + p] = cost_min;
-
-          for (p[2] = 0; p[2] < static_cast<int>(msg->angle); p[2]++)
-          {
-            const size_t addr = ((p[2] * msg->height) + p[1]) * msg->width + p[0];
-            const char c = msg->data[addr];
-            if (overwrite_cost_)
-            {
-              if (c >= 0)
-                cm_[gp + p] = c;
-            }
-            else
-            {
-              if (cm_[gp + p] < c)
-                cm_[gp + p] = c;
-            }
-          }
+          const char c = costs[i];
+          if (c < cost_min)
+            cost_min = c;
+          if (c == 100 && !clear_hysteresis.load(std::memory_order_relaxed) && cm_hyst_[p_yaw] == 0)
+            clear_hysteresis.store(true, std::memory_order_relaxed);
         }
-      }
+        const Astar::Vec p_rough(p[0], p[1], 0);
+        cm_updates_[p_rough] = cost_min;
+        if (cost_min > cm_rough_[p_rough])
+          cm_rough_[p_rough] = cost_min;
+      };
+      const auto ts = boost::chrono::high_resolution_clock::now();
+      mergeCostmapUpdate(
+          cm_, gp,
+          Astar::Vec(static_cast<int>(msg->width), static_cast<int>(msg->height), angle),
+          msg->data.data(),
+          overwrite_cost_, cb_column);
+      const auto tnow = boost::chrono::high_resolution_clock::now();
+      ROS_DEBUG("Costmap update merged (%0.4f sec.)",
+                boost::chrono::duration<float>(tnow - ts).count());
+      lethal_mask_.update(cm_, gp_rough, gp_end);
     }
 
     if (clear_hysteresis && has_hysteresis_map_)
@@ -889,7 +1203,39 @@ protected:
       ROS_INFO("The previous path collides to the obstacle. Clearing hysteresis map.");
       cm_hyst_.clear(100);
       has_hysteresis_map_ = false;
+      hyst_path_grid_.clear();
+      as_.invalidateAll();
+      edge_cost_cache_.invalidateAll();
+    }
+
+    // Area changed from the previous update
+    Astar::Vec changed_min(static_cast<int>(msg->x), static_cast<int>(msg->y), 0);
+    Astar::Vec changed_max(
+        static_cast<int>(msg->x + msg->width), static_cast<int>(msg->y + msg->height), 0);
+    {
+      // Costs of the motions passing through the previous and the current updated area
+      // might be changed.
+      const Astar::Vec update_min(
+          static_cast<int>(msg->x) - range_, static_cast<int>(msg->y) - range_, 0);
+      const Astar::Vec update_max(
+          static_cast<int>(msg->x + msg->width) + range_, static_cast<int>(msg->y + msg->height) + range_, 0);
+      if (has_update_prev_)
+      {
+        as_.invalidate(update_min_prev_, update_max_prev_);
+        edge_cost_cache_.invalidate(update_min_prev_, update_max_prev_);
+        for (int i = 0; i < 2; ++i)
+        {
+          changed_min[i] = std::min(changed_min[i], update_min_prev_[i]);
+          changed_max[i] = std::max(changed_max[i], update_max_prev_[i]);
+        }
+      }
+      as_.invalidate(update_min, update_max);
+      edge_cost_cache_.invalidate(update_min, update_max);
+      update_min_prev_ = update_min;
+      update_max_prev_ = update_max;
+      has_update_prev_ = true;
     }
+    addCostEstimCacheChange(changed_min, changed_max);
 
     if (!has_start_)
       return;
@@ -903,6 +1249,14 @@ protected:
 
     if (remember_updates_)
     {
+      const Astar::Vec remembered_min(s[0] - hist_ignore_range_max_, s[1] - hist_ignore_range_max_, 0);
+      const Astar::Vec remembered_max(s[0] + hist_ignore_range_max_ + 1, s[1] + hist_ignore_range_max_ + 1, 0);
+      for (int i = 0; i < 2; ++i)
+      {
+        changed_min[i] = std::min(changed_min[i], remembered_min[i]);
+        changed_max[i] = std::max(changed_max[i], remembered_max[i]);
+      }
+      addCostEstimCacheChange(remembered_min, remembered_max);
       bbf_costmap_.remember(
           &cm_updates_, s,
           remember_hit_odds_, remember_miss_odds_,
@@ -924,103 +1278,51 @@ protected:
         map_info_, e[0], e[1], e[2],
         goal_.pose.position.x, goal_.pose.position.y,
         tf2::getYaw(goal_.pose.orientation));
-    e.cycleUnsigned(map_info_.angle);
-
-    if (cm_[e] == 100)
-    {
-      updateGoal(false);
-      return;
-    }
-
-    e[2] = 0;
-
-    const auto ts = boost::chrono::high_resolution_clock::now();
-
-    Astar::Vec p, p_cost_min;
-    p[2] = 0;
-    float cost_min = FLT_MAX;
-    for (p[1] = static_cast<int>(msg->y); p[1] < static_cast<int>(msg->y + msg->height); p[1]++)
-    {
-      for (p[0] = static_cast<int>(msg->x); p[0] < static_cast<int>(msg->x + msg->width); p[0]++)
-      {
-        if (cost_min > cost_estim_cache_[p])
-        {
-          p_cost_min = p;
-          cost_min = cost_estim_cache_[p];
-        }
-      }
-    }
-
-    reservable_priority_queue<Astar::PriorityVec> open;
-    reservable_priority_queue<Astar::PriorityVec> erase;
-    open.reserve(map_info_.width * map_info_.height / 2);
-    erase.reserve(map_info_.width * map_info_.height / 2);
-
-    if (cost_min != FLT_MAX)
-      erase.emplace(cost_min, cost_min, p_cost_min);
-    while (true)
-    {
-      if (erase.size() < 1)
-        break;
-      const Astar::PriorityVec center(erase.top());
-      const Astar::Vec p = center.v_;
-      erase.pop();
-
-      if (cost_estim_cache_[p] == FLT_MAX)
-        continue;
-      cost_estim_cache_[p] = FLT_MAX;
-
-      Astar::Vec d;
-      d[2] = 0;
-      for (d[0] = -1; d[0] <= 1; d[0]++)
-      {
-        for (d[1] = -1; d[1] <= 1; d[1]++)
-        {
-          if (!((d[0] == 0) ^ (d[1] == 0)))
-            continue;
-          Astar::Vec next = p + d;
-          next[2] = 0;
-          if ((unsigned int)next[0] >= (unsigned int)map_info_.width ||
-              (unsigned int)next[1] >= (unsigned int)map_info_.height)
-            continue;
-          const float gn = cost_estim_cache_[next];
-          if (gn == FLT_MAX)
-            continue;
-          if (gn < cost_min)
-          {
-            open.emplace(gn, gn, next);
-            continue;
-          }
-          erase.emplace(gn, gn, next);
-        }
-      }
-    }
-    if (open.size() == 0)
-    {
-      open.emplace(-ec_[0] * 0.5, -ec_[0] * 0.5, e);
-    }
-    {
-      Astar::Vec p;
-      p[2] = 0;
-      for (p[0] = 0; p[0] < static_cast<int>(map_info_.width); p[0]++)
-      {
-        for (p[1] = 0; p[1] < static_cast<int>(map_info_.height); p[1]++)
-        {
-          const auto gp = cost_estim_cache_[p];
-          if (gp > rough_cost_max_)
-          {
-            open.emplace(gp, gp, p);
-          }
-        }
-      }
+    e.cycleUnsigned(map_info_.angle);
+
+    if (cm_[e] == 100)
+    {
+      updateGoal(false);
+      return;
     }
 
-    fillCostmap(open, cost_estim_cache_, s, e);
+    const auto ts = boost::chrono::high_resolution_clock::now();
+    updateCostmap(std::vector<DistanceMap::Region>(1, DistanceMap::Region(changed_min, changed_max)), s);
     const auto tnow = boost::chrono::high_resolution_clock::now();
     ROS_DEBUG("Cost estimation cache updated (%0.4f sec.)",
               boost::chrono::duration<float>(tnow - ts).count());
     publishDebug();
   }
+  void resetMotionCache(
+      MotionCache& cache,
+      const std::string& name,
+      const float linear_resolution,
+      const float angular_resolution,
+      const int range,
+      const std::function<void(CyclicVecInt<3, 2>, size_t&, size_t&)> gm_addr)
+  {
+    if (motion_cache_dir_.empty())
+    {
+      cache.reset(linear_resolution, angular_resolution, range, gm_addr);
+      return;
+    }
+    // Cache files are named by the parameters to keep the caches of the multiple maps.
+    char file_name[128];
+    snprintf(file_name, sizeof(file_name), "%s_%0.6f_%0.6f_%d.bin",
+             name.c_str(), linear_resolution, angular_resolution, range);
+    const std::string path = motion_cache_dir_ + "/" + file_name;
+
+    if (cache.load(path, linear_resolution, angular_resolution, range, gm_addr))
+    {
+      ROS_INFO("%s is loaded from %s", name.c_str(), path.c_str());
+      return;
+    }
+    cache.reset(linear_resolution, angular_resolution, range, gm_addr);
+    if (cache.save(path))
+      ROS_INFO("%s is saved to %s", name.c_str(), path.c_str());
+    else
+      ROS_WARN("Failed to save %s to %s", name.c_str(), path.c_str());
+  }
   void cbMap(const costmap_cspace_msgs::CSpace3D::ConstPtr& msg)
   {
     ROS_INFO("Map received");
@@ -1041,6 +1343,24 @@ protected:
         1.0f / max_vel_,
         1.0f * cc_.weight_ang_vel_ / max_ang_vel_);
     createEuclidCostCache();
+    distance_map_.setParams(
+        DistanceMap::Params
+        {
+          ec_[0],
+          msg->info.linear_resolution,
+          cc_.weight_costmap_,
+          cc_.weight_remembered_,
+        });
+
+    // Motion caches are sorted by the addressors of the costmaps, which must have the new size.
+    const int size[3] =
+        {
+          static_cast<int>(msg->info.width),
+          static_cast<int>(msg->info.height),
+          static_cast<int>(msg->info.angle)
+        };
+    cm_.reset(Astar::Vec(size[0], size[1], size[2]));
+    cm_rough_.reset(Astar::Vec(size[0], size[1], 1));
 
     if (map_info_.linear_resolution != msg->info.linear_resolution ||
         map_info_.angular_resolution != msg->info.angular_resolution)
@@ -1051,12 +1371,14 @@ protected:
 
       costmap_cspace_msgs::MapMetaData3D map_info_linear(map_info_);
       map_info_linear.angle = 1;
-      motion_cache_linear_.reset(
+      resetMotionCache(
+          motion_cache_linear_, "motion_cache_linear",
           map_info_linear.linear_resolution,
           map_info_linear.angular_resolution,
           range_,
           cm_rough_.getAddressor());
-      motion_cache_.reset(
+      resetMotionCache(
+          motion_cache_, "motion_cache",
           map_info_.linear_resolution,
           map_info_.angular_resolution,
           range_,
@@ -1092,6 +1414,9 @@ protected:
       rot_cache_.reset(map_info_.linear_resolution, map_info_.angular_resolution, range_);
       path_interpolator_.reset(map_info_.angular_resolution, range_);
       ROS_DEBUG("Rotation cache generated");
+
+      angle_resolution_aspect_ = 2.0 / tanf(map_info_.angular_resolution);
+      createMotionPrimitives();
     }
     else
     {
@@ -1115,45 +1440,52 @@ protected:
     goal_tolerance_lin_ = lroundf(goal_tolerance_lin_f_ / map_info_.linear_resolution);
     goal_tolerance_ang_ = lroundf(goal_tolerance_ang_f_ / map_info_.angular_resolution);
 
-    const int size[3] =
-        {
-          static_cast<int>(map_info_.width),
-          static_cast<int>(map_info_.height),
-          static_cast<int>(map_info_.angle)
-        };
     as_.reset(Astar::Vec(size[0], size[1], size[2]));
-    cm_.reset(Astar::Vec(size[0], size[1], size[2]));
+    size_t edge_num = 0;
+    for (const std::vector<Astar::Vec>& search_list : search_list_yaw_)
+      edge_num = std::max(edge_num, search_list.size());
+    edge_cost_cache_.reset(
+        Astar::Vec(size[0], size[1], size[2]), edge_num,
+        static_cast<size_t>(std::max(edge_cost_cache_memory_mb_, 0)) * 1024 * 1024);
     cm_hyst_.reset(Astar::Vec(size[0], size[1], size[2]));
+    cm_hyst_next_.reset(Astar::Vec(size[0], size[1], size[2]));
+    hyst_min_ = hyst_max_ = Astar::Vec(0, 0, 0);
+    lethal_mask_.reset(Astar::Vec(size[0], size[1], size[2]));
 
     cost_estim_cache_.reset(Astar::Vec(size[0], size[1], 1));
-    cm_rough_.reset(Astar::Vec(size[0], size[1], 1));
+    cost_estim_cache_pool_.clear();
+    has_cost_estim_cache_ = false;
+    const size_t cost_estim_cache_entry_size =
+        static_cast<size_t>(size[0]) * size[1] * (sizeof(float) + sizeof(uint32_t) + sizeof(char));
+    cost_estim_cache_pool_size_ =
+        static_cast<size_t>(std::max(goal_cache_memory_mb_, 0)) * 1024 * 1024 / cost_estim_cache_entry_size;
     cm_updates_.reset(Astar::Vec(size[0], size[1], 1));
     bbf_costmap_.reset(Astar::Vec(size[0], size[1], 1));
 
-    Astar::Vec p;
-    for (p[0] = 0; p[0] < static_cast<int>(map_info_.width); p[0]++)
-    {
-      for (p[1] = 0; p[1] < static_cast<int>(map_info_.height); p[1]++)
-      {
-        int cost_min = 100;
-        for (p[2] = 0; p[2] < static_cast<int>(map_info_.angle); p[2]++)
+    const int angle = size[2];
+    const auto ts = boost::chrono::high_resolution_clock::now();
+    importCostmap(
+        cm_, msg->data.data(), unknown_cost_,
+        [this, angle](const Astar::Vec& p, const char* costs)
         {
-          const size_t addr = ((p[2] * size[1]) + p[1]) * size[0] + p[0];
-          char c = msg->data[addr];
-          if (c < 0)
-            c = unknown_cost_;
-          cm_[p] = c;
-          if (c < cost_min)
-            cost_min = c;
-        }
-        p[2] = 0;
-        cm_rough_[p] = cost_min;
-      }
-    }
+          int cost_min = 100;
+          for (int i = 0; i < angle; ++i)
+          {
+            if (costs[i] < cost_min)
+              cost_min = costs[i];
+          }
+          cm_rough_[Astar::Vec(p[0], p[1], 0)] = cost_min;
+        });
+    const auto tnow = boost::chrono::high_resolution_clock::now();
+    ROS_DEBUG("Map imported (%0.4f sec.)",
+              boost::chrono::duration<float>(tnow - ts).count());
+    lethal_mask_.update(cm_, Astar::Vec(0, 0, 0), Astar::Vec(size[0], size[1], 0));
     ROS_DEBUG("Map copied");
 
     cm_hyst_.clear(100);
     has_hysteresis_map_ = false;
+    hyst_path_grid_.clear();
+    has_update_prev_ = false;
 
     has_map_ = true;
 
@@ -1198,27 +1530,96 @@ protected:
       has_start_ = false;
       return;
     }
+    if (has_start_)
+    {
+      start_prev_ = start_;
+      has_start_prev_ = true;
+    }
     start_ = start;
     has_start_ = true;
+
+    if (has_start_prev_)
+    {
+      const float dt = (start_.header.stamp - start_prev_.header.stamp).toSec();
+      if (dt > 0.0)
+      {
+        const float vel = estimateLinearVelocity(metricPose(start_prev_.pose), metricPose(start_.pose), dt);
+        start_vel_ = std::min(vel, max_vel_);
+      }
+    }
+  }
+
+  static Astar::Vecf metricPose(const geometry_msgs::Pose& pose)
+  {
+    return Astar::Vecf(
+        static_cast<float>(pose.position.x),
+        static_cast<float>(pose.position.y),
+        static_cast<float>(tf2::getYaw(pose.orientation)));
+  }
+  // Predict the pose of the robot at the end of the planning by moving the start pose
+  // along the previously published path by the distance traveled during the latency.
+  // The part of the previous path between the start and the predicted pose is stored to prefix.
+  bool predictStart(
+      geometry_msgs::Pose& predicted,
+      std::vector<geometry_msgs::PoseStamped>& prefix)
+  {
+    const float dist_latency = start_vel_ * plan_latency_;
+    if (dist_latency < map_info_.linear_resolution * 0.5)
+      return false;
+
+    std::vector<Astar::Vecf> path;
+    path.reserve(path_prev_.poses.size());
+    for (const geometry_msgs::PoseStamped& p : path_prev_.poses)
+      path.push_back(metricPose(p.pose));
+    size_t i_nearest, i_predicted;
+    if (!predictPoseOnPath(
+            path, metricPose(start_.pose), dist_latency, cc_.hysteresis_max_dist_, i_nearest, i_predicted))
+      return false;
+
+    // Near the goal, the robot is expected to stop before the predicted pose.
+    const geometry_msgs::Pose& p = path_prev_.poses[i_predicted].pose;
+    if (std::hypot(p.position.x - goal_.pose.position.x, p.position.y - goal_.pose.position.y) <
+        goal_tolerance_lin_f_)
+      return false;
+
+    Astar::Vec pg;
+    grid_metric_converter::metric2Grid(
+        map_info_, pg[0], pg[1], pg[2],
+        p.position.x, p.position.y, tf2::getYaw(p.orientation));
+    pg.cycleUnsigned(map_info_.angle);
+    if (!cm_.validate(pg, range_) || cm_[pg] > 99)
+      return false;
+
+    predicted = p;
+    prefix.assign(path_prev_.poses.begin() + i_nearest, path_prev_.poses.begin() + i_predicted);
+    return true;
   }
 
 public:
   Planner3dNode()
     : nh_()
     , pnh_("~")
+    , nh_receive_()
+    , pnh_receive_("~")
+    , spinner_receive_(1, &queue_receive_)
     , tfl_(tfbuf_)
+    , distance_map_(cm_rough_, bbf_costmap_)
+    , cost_estim_cache_pool_size_(0)
+    , has_cost_estim_cache_(false)
     , jump_(tfbuf_)
   {
     neonavigation_common::compat::checkCompatMode();
+    nh_receive_.setCallbackQueue(&queue_receive_);
+    pnh_receive_.setCallbackQueue(&queue_receive_);
     sub_map_ = neonavigation_common::compat::subscribe(
-        nh_, "costmap",
-        pnh_, "costmap", 1, &Planner3dNode::cbMap, this);
+        nh_receive_, "costmap",
+        pnh_receive_, "costmap", 1, &Planner3dNode::cbMapReceived, this);
     sub_map_update_ = neonavigation_common::compat::subscribe(
-        nh_, "costmap_update",
-        pnh_, "costmap_update", 1, &Planner3dNode::cbMapUpdate, this);
+        nh_receive_, "costmap_update",
+        pnh_receive_, "costmap_update", 1, &Planner3dNode::cbMapUpdateReceived, this);
     sub_goal_ = neonavigation_common::compat::subscribe(
-        nh_, "move_base_simple/goal",
-        pnh_, "goal", 1, &Planner3dNode::cbGoal, this);
+        nh_receive_, "move_base_simple/goal",
+        pnh_receive_, "goal", 1, &Planner3dNode::cbGoalReceived, this);
     pub_start_ = pnh_.advertise<geometry_msgs::PoseStamped>("path_start", 1, true);
     pub_end_ = pnh_.advertise<geometry_msgs::PoseStamped>("path_end", 1, true);
     pub_status_ = pnh_.advertise<planner_cspace_msgs::PlannerStatus>("status", 1, true);
@@ -1232,9 +1633,9 @@ public:
     pub_hysteresis_map_ = pnh_.advertise<nav_msgs::OccupancyGrid>("hysteresis_map", 1, true);
     pub_remembered_map_ = pnh_.advertise<nav_msgs::OccupancyGrid>("remembered_map", 1, true);
 
-    act_.reset(new Planner3DActionServer(ros::NodeHandle(), "move_base", false));
-    act_->registerGoalCallback(boost::bind(&Planner3dNode::cbAction, this));
-    act_->registerPreemptCallback(boost::bind(&Planner3dNode::cbPreempt, this));
+    act_.reset(new Planner3DActionServer(nh_receive_, "move_base", false));
+    act_->registerGoalCallback(boost::bind(&Planner3dNode::cbActionReceived, this));
+    act_->registerPreemptCallback(boost::bind(&Planner3dNode::cbPreemptReceived, this));
 
     pnh_.param("use_path_with_velocity", use_path_with_velocity_, false);
     if (use_path_with_velocity_)
@@ -1254,6 +1655,7 @@ public:
     pnh_.param("freq", freq_, 4.0f);
     pnh_.param("freq_min", freq_min_, 2.0f);
     pnh_.param("search_range", search_range_, 0.4f);
+    pnh_.param("yaw_heuristic_range", yaw_heuristic_range_f_, 0.0);
     pnh_.param("antialias_start", antialias_start_, false);
 
     double costmap_watchdog;
@@ -1319,6 +1721,24 @@ public:
     {
       ROS_WARN("planner_3d: Experimental fast_map_update is enabled. ");
     }
+    pnh_.param("incremental_search", incremental_search_, false);
+    pnh_.param("motion_cache_dir", motion_cache_dir_, std::string(""));
+    pnh_.param("goal_cache_memory_mb", goal_cache_memory_mb_, 0);
+    pnh_.param("edge_cost_cache_memory_mb", edge_cost_cache_memory_mb_, 0);
+    pnh_.param("compensate_latency", compensate_latency_, false);
+    pnh_.param("latency_smoothing_factor", latency_smoothing_factor_, 0.2f);
+    as_.setIncremental(incremental_search_);
+
+    double planning_deadline;
+    double anytime_weight;
+    double anytime_weight_step;
+    pnh_.param("planning_deadline", planning_deadline, 0.0);
+    pnh_.param("anytime_heuristic_weight", anytime_weight, 2.0);
+    pnh_.param("anytime_heuristic_weight_step", anytime_weight_step, 0.5);
+    if (planning_deadline > 0.0)
+      as_.setAnytime(anytime_weight, anytime_weight_step, planning_deadline);
+    has_update_prev_ = false;
+    hyst_prev_ = false;
     if (pnh_.hasParam("debug_mode"))
     {
       ROS_ERROR(
@@ -1342,6 +1762,20 @@ public:
     pnh_.param("queue_size_limit", queue_size_limit, 0);
     as_.setQueueSizeLimit(queue_size_limit);
 
+    std::string open_list_type;
+    pnh_.param("open_list_type", open_list_type,
+               std::string(queue_size_limit > 0 ? "min_max_heap" : "binary_heap"));
+    try
+    {
+      open_list_type_ = priorityQueueTypeFromString(open_list_type);
+    }
+    catch (const std::invalid_argument& e)
+    {
+      ROS_ERROR("%s, binary_heap is used.", e.what());
+      open_list_type_ = PriorityQueueType::BINARY_HEAP;
+    }
+    as_.setQueueType(open_list_type_);
+
     int num_threads;
     pnh_.param("num_threads", num_threads, 1);
     omp_set_num_threads(num_threads);
@@ -1349,7 +1783,8 @@ public:
     int num_task;
     pnh_.param("num_search_task", num_task, num_threads * 16);
     as_.setSearchTaskNum(num_task);
-    pnh_.param("num_cost_estim_task", num_cost_estim_task_, num_threads * 16);
+    if (num_task == 0)
+      ROS_INFO("Hash distributed A* is enabled with %d threads", num_threads);
 
     pnh_.param("retain_last_error_status", retain_last_error_status_, true);
     status_.status = planner_cspace_msgs::PlannerStatus::DONE;
@@ -1357,7 +1792,12 @@ public:
     has_map_ = false;
     has_goal_ = false;
     has_start_ = false;
+    has_start_prev_ = false;
+    start_vel_ = 0;
+    plan_latency_ = 0;
     goal_updated_ = false;
+    plan_canceled_ = false;
+    search_cancelable_ = true;
 
     escaping_ = false;
     cnt_stuck_ = 0;
@@ -1367,15 +1807,22 @@ public:
 
     act_->start();
   }
+  ~Planner3dNode()
+  {
+    spinner_receive_.stop();
+  }
+
   void spin()
   {
     ros::Rate wait(freq_);
+    spinner_receive_.start();
     ROS_DEBUG("Initialized");
 
     while (ros::ok())
     {
       wait.sleep();
       ros::spinOnce();
+      processPendingCallbacks();
 
       const ros::Time now = ros::Time::now();
 
@@ -1471,24 +1918,49 @@ public:
           nav_msgs::Path path;
           path.header = map_header_;
           path.header.stamp = now;
-          makePlan(start_.pose, goal_.pose, path, true);
-          if (use_path_with_velocity_)
+
+          // Plan from the pose where the robot will be when the path is published.
+          geometry_msgs::Pose start_plan = start_.pose;
+          std::vector<geometry_msgs::PoseStamped> prefix;
+          if (compensate_latency_ && predictStart(start_plan, prefix))
           {
-            // NaN velocity means that don't care the velocity
-            pub_path_velocity_.publish(
-                trajectory_tracker_msgs::toPathWithVelocity(path, std::numeric_limits<double>::quiet_NaN()));
+            ROS_DEBUG("Planning from the predicted pose (%0.3f, %0.3f) (latency: %0.3f sec.)",
+                      start_plan.position.x, start_plan.position.y, plan_latency_);
           }
-          else
+          const auto ts = boost::chrono::high_resolution_clock::now();
+          makePlan(start_plan, goal_.pose, path, true);
+          if (plan_canceled_)
           {
-            pub_path_.publish(path);
+            // Keep the previous path until the messages which canceled the search are processed.
+            ROS_DEBUG("Path plan canceled by the new map or goal");
           }
-
-          if (sw_wait_ > 0.0)
+          else
           {
-            if (switchDetect(path))
+            if (!prefix.empty() && !path.poses.empty())
+              path.poses.insert(path.poses.begin(), prefix.begin(), prefix.end());
+            if (use_path_with_velocity_)
+            {
+              // NaN velocity means that don't care the velocity
+              pub_path_velocity_.publish(
+                  trajectory_tracker_msgs::toPathWithVelocity(path, std::numeric_limits<double>::quiet_NaN()));
+            }
+            else
+            {
+              pub_path_.publish(path);
+            }
+            path_prev_ = path;
+            const auto tnow = boost::chrono::high_resolution_clock::now();
+            plan_latency_ =
+                plan_latency_ * (1.0 - latency_smoothing_factor_) +
+                boost::chrono::duration<float>(tnow - ts).count() * latency_smoothing_factor_;
+
+            if (sw_wait_ > 0.0)
             {
-              ROS_INFO("Planned path has switchback");
-              ros::Duration(sw_wait_).sleep();
+              if (switchDetect(path))
+              {
+                ROS_INFO("Planned path has switchback");
+                ros::Duration(sw_wait_).sleep();
+              }
             }
           }
         }
@@ -1508,6 +1980,8 @@ protected:
   bool makePlan(const geometry_msgs::Pose& gs, const geometry_msgs::Pose& ge,
                 nav_msgs::Path& path, bool hyst)
   {
+    plan_canceled_ = false;
+
     Astar::Vec e;
     grid_metric_converter::metric2Grid(
         map_info_, e[0], e[1], e[2],
@@ -1652,41 +2126,77 @@ protected:
     pub_start_.publish(p);
 
     const float range_limit = cost_estim_cache_[s_rough] - (local_range_ + range_) * ec_[0];
-    angle_resolution_aspect_ = 2.0 / tanf(map_info_.angular_resolution);
+    if (yaw_heuristic_table_.enabled() && !yaw_heuristic_table_.created(e[2]))
+    {
+      const auto ts = boost::chrono::high_resolution_clock::now();
+      yaw_heuristic_table_.create(e[2]);
+      const auto tnow = boost::chrono::high_resolution_clock::now();
+      ROS_DEBUG("Yaw heuristic table generated for yaw %d (%0.4f sec.)",
+                e[2], boost::chrono::duration<float>(tnow - ts).count());
+    }
 
     const auto ts = boost::chrono::high_resolution_clock::now();
     // ROS_INFO("Planning from (%d, %d, %d) to (%d, %d, %d)",
     //   s[0], s[1], s[2], e[0], e[1], e[2]);
 
-    std::list<Astar::Vec> path_grid;
+    if (hyst != hyst_prev_)
+    {
+      as_.invalidateAll();
+      edge_cost_cache_.invalidateAll();
+      hyst_prev_ = hyst;
+    }
+    path_grid_.clear();
+    const auto cb_cost = [this, hyst](
+        const Astar::Vec& s, const Astar::Vec& e,
+        const std::vector<Astar::VecWithCost>& v_start,
+        const Astar::Vec& v_goal) -> float
+    {
+      return cbCost(s, e, v_start, v_goal, hyst);
+    };
+    const auto cb_cost_estim = [this](
+        const Astar::Vec& s, const Astar::Vec& e) -> float
+    {
+      return cbCostEstim(s, e);
+    };
+    const auto cb_search = [this](
+        const Astar::Vec& p,
+        const std::vector<Astar::VecWithCost>& ss,
+        const Astar::Vec& es) -> std::vector<Astar::Vec>&
+    {
+      return cbSearch(p, ss, es);
+    };
+    const auto cb_progress = [this](const std::vector<Astar::Vec>& path_grid)
+    {
+      return cbProgress(path_grid);
+    };
+    search_starts_ = starts;
     if (!as_.search(
-            starts, e, path_grid,
-            std::bind(&Planner3dNode::cbCost,
-                      this, std::placeholders::_1, std::placeholders::_2,
-                      std::placeholders::_3, std::placeholders::_4, hyst),
-            std::bind(&Planner3dNode::cbCostEstim,
-                      this, std::placeholders::_1, std::placeholders::_2),
-            std::bind(&Planner3dNode::cbSearch,
-                      this, std::placeholders::_1,
-                      std::placeholders::_2, std::placeholders::_3),
-            std::bind(&Planner3dNode::cbProgress,
-                      this, std::placeholders::_1),
+            starts, e, path_grid_,
+            cb_cost, cb_cost_estim, cb_search, cb_progress,
             range_limit,
             1.0f / freq_min_,
             true))
     {
+      if (as_.isCanceled())
+      {
+        plan_canceled_ = true;
+        return false;
+      }
       ROS_WARN("Path plan failed (goal unreachable)");
       status_.error = planner_cspace_msgs::PlannerStatus::PATH_NOT_FOUND;
       if (!find_best_)
         return false;
     }
     const auto tnow = boost::chrono::high_resolution_clock::now();
-    ROS_DEBUG("Path found (%0.4f sec.)",
-              boost::chrono::duration<float>(tnow - ts).count());
+    ROS_DEBUG("Path found (%0.4f sec., suboptimality bound %0.2f, %d nodes expanded)",
+              boost::chrono::duration<float>(tnow - ts).count(),
+              as_.getSuboptimalityBound(),
+              static_cast<int>(as_.getExpandedNodeNum()));
 
     geometry_msgs::PoseArray poses;
     poses.header = path.header;
-    for (const auto& p : path_grid)
+    poses.poses.reserve(path_grid_.size());
+    for (const auto& p : path_grid_)
     {
       geometry_msgs::Pose pose;
       float x, y, yaw;
@@ -1699,70 +2209,142 @@ protected:
     }
     pub_path_poses_.publish(poses);
 
-    const std::list<Astar::Vecf> path_interpolated =
-        path_interpolator_.interpolate(path_grid, 0.5, local_range_);
-    grid_metric_converter::grid2MetricPath(map_info_, path_interpolated, path);
+    // Interpolated path is shared by the published path and the hysteresis map.
+    path_interpolator_.interpolate(path_grid_, 0.5, local_range_, path_interpolated_);
+    grid_metric_converter::grid2MetricPath(map_info_, path_interpolated_, path);
 
     if (hyst)
     {
-      const std::list<Astar::Vecf> path_interpolated =
-          path_interpolator_.interpolate(path_grid, 0.5, local_range_);
-
-      std::unordered_map<Astar::Vec, bool, Astar::Vec> path_points;
-      const float max_dist = cc_.hysteresis_max_dist_ / map_info_.linear_resolution;
-      const float expand_dist = cc_.hysteresis_expand_ / map_info_.linear_resolution;
-      const int path_range = range_ + max_dist + expand_dist + 5;
-      for (const Astar::Vecf& p : path_interpolated)
+      if (path_grid_ != hyst_path_grid_)
       {
-        Astar::Vec d;
-        for (d[0] = -path_range; d[0] <= path_range; d[0]++)
+        // Hysteresis map is changed only if the path is changed.
+        hyst_path_grid_ = path_grid_;
+
+        const float max_dist = cc_.hysteresis_max_dist_ / map_info_.linear_resolution;
+        const float expand_dist = cc_.hysteresis_expand_ / map_info_.linear_resolution;
+        // Cells farther than this from the path segments have the maximum cost.
+        const float dist_limit = expand_dist + max_dist;
+        const int width = map_info_.width;
+        const int height = map_info_.height;
+        const int angle = map_info_.angle;
+
+        const auto ts = boost::chrono::high_resolution_clock::now();
+        Astar::Vec next_min(width, height, 0);
+        Astar::Vec next_max(0, 0, 0);
+        for (const Astar::Vecf& a : path_interpolated_)
+        {
+          next_min[0] = std::min(next_min[0], std::max(static_cast<int>(std::floor(a[0] - dist_limit)), 0));
+          next_min[1] = std::min(next_min[1], std::max(static_cast<int>(std::floor(a[1] - dist_limit)), 0));
+          next_max[0] = std::max(next_max[0], std::min(static_cast<int>(std::ceil(a[0] + dist_limit)) + 1, width));
+          next_max[1] = std::max(next_max[1], std::min(static_cast<int>(std::ceil(a[1] + dist_limit)) + 1, height));
+        }
+        const auto inside_next = [&next_min, &next_max](const Astar::Vec& p)
+        {
+          return next_min[0] <= p[0] && p[0] < next_max[0] && next_min[1] <= p[1] && p[1] < next_max[1];
+        };
+        Astar::Vec pos;
+        for (pos[1] = next_min[1]; pos[1] < next_max[1]; pos[1]++)
         {
-          for (d[1] = -path_range; d[1] <= path_range; d[1]++)
+          for (pos[0] = next_min[0]; pos[0] < next_max[0]; pos[0]++)
           {
-            Astar::Vec point = p + d;
-            point.cycleUnsigned(map_info_.angle);
-            if ((unsigned int)point[0] >= (unsigned int)map_info_.width ||
-                (unsigned int)point[1] >= (unsigned int)map_info_.height)
-              continue;
-            path_points[point] = true;
+            for (pos[2] = 0; pos[2] < angle; pos[2]++)
+              cm_hyst_next_[pos] = 100;
           }
         }
-      }
 
-      cm_hyst_.clear(100);
-      const auto ts = boost::chrono::high_resolution_clock::now();
-      for (auto& ps : path_points)
-      {
-        const Astar::Vec& p = ps.first;
-        float d_min = FLT_MAX;
-        auto it_prev = path_interpolated.begin();
-        for (auto it = path_interpolated.begin(); it != path_interpolated.end(); it++)
+        // Each path segment lowers the costs around it on the yaw layers of its ends.
+        auto it_prev = path_interpolated_.begin();
+        for (auto it = path_interpolated_.begin(); it != path_interpolated_.end(); it++)
         {
-          if (it != it_prev)
+          if (it == it_prev)
+            continue;
+          const Astar::Vecf& a = *it_prev;
+          const Astar::Vecf& b = *it;
+          it_prev = it;
+
+          int yaw = lroundf(b[2]) % angle;
+          int yaw_prev = lroundf(a[2]) % angle;
+          if (yaw < 0)
+            yaw += angle;
+          if (yaw_prev < 0)
+            yaw_prev += angle;
+
+          const int x_min = std::max(static_cast<int>(std::floor(std::min(a[0], b[0]) - dist_limit)), 0);
+          const int y_min = std::max(static_cast<int>(std::floor(std::min(a[1], b[1]) - dist_limit)), 0);
+          const int x_max = std::min(static_cast<int>(std::ceil(std::max(a[0], b[0]) + dist_limit)), width - 1);
+          const int y_max = std::min(static_cast<int>(std::ceil(std::max(a[1], b[1]) + dist_limit)), height - 1);
+          Astar::Vec p(0, 0, yaw);
+          for (p[1] = y_min; p[1] <= y_max; p[1]++)
           {
-            int yaw = lroundf((*it)[2]) % map_info_.angle;
-            int yaw_prev = lroundf((*it_prev)[2]) % map_info_.angle;
-            if (yaw < 0)
-              yaw += map_info_.angle;
-            if (yaw_prev < 0)
-              yaw_prev += map_info_.angle;
-            if (yaw == p[2] || yaw_prev == p[2])
+            for (p[0] = x_min; p[0] <= x_max; p[0]++)
             {
-              const float d =
-                  CyclicVecFloat<3, 2>(p).distLinestrip2d(*it_prev, *it);
-              if (d < d_min)
-                d_min = d;
+              const float d = CyclicVecFloat<3, 2>(p).distLinestrip2d(a, b);
+              if (d >= dist_limit)
+                continue;
+              const char cost = lroundf((std::max(expand_dist, d) - expand_dist) * 100.0 / max_dist);
+              p[2] = yaw;
+              if (cost < cm_hyst_next_[p])
+                cm_hyst_next_[p] = cost;
+              p[2] = yaw_prev;
+              if (cost < cm_hyst_next_[p])
+                cm_hyst_next_[p] = cost;
             }
           }
-          it_prev = it;
         }
-        d_min = std::max(expand_dist, std::min(expand_dist + max_dist, d_min));
-        cm_hyst_[p] = lroundf((d_min - expand_dist) * 100.0 / max_dist);
+
+        // Copy the new map and find the changed cells in the previous and the new regions.
+        Astar::Vec changed_min(width, height, 0);
+        Astar::Vec changed_max(-1, -1, 0);
+        Astar::Vec merged_min = next_min;
+        Astar::Vec merged_max = next_max;
+        if (hyst_min_[0] < hyst_max_[0])
+        {
+          for (int i = 0; i < 2; ++i)
+          {
+            merged_min[i] = std::min(merged_min[i], hyst_min_[i]);
+            merged_max[i] = std::max(merged_max[i], hyst_max_[i]);
+          }
+        }
+        for (pos[1] = merged_min[1]; pos[1] < merged_max[1]; pos[1]++)
+        {
+          for (pos[0] = merged_min[0]; pos[0] < merged_max[0]; pos[0]++)
+          {
+            const bool inside = inside_next(pos);
+            for (pos[2] = 0; pos[2] < angle; pos[2]++)
+            {
+              const char cost = inside ? cm_hyst_next_[pos] : 100;
+              char& cost_prev = cm_hyst_[pos];
+              if (cost == cost_prev)
+                continue;
+              cost_prev = cost;
+              changed_min[0] = std::min(changed_min[0], pos[0]);
+              changed_min[1] = std::min(changed_min[1], pos[1]);
+              changed_max[0] = std::max(changed_max[0], pos[0]);
+              changed_max[1] = std::max(changed_max[1], pos[1]);
+            }
+          }
+        }
+        hyst_min_ = next_min;
+        hyst_max_ = next_max;
+        if (changed_max[0] >= 0)
+        {
+          // Costs of the motions passing through the changed cells might be changed.
+          const Astar::Vec update_min(changed_min[0] - range_, changed_min[1] - range_, 0);
+          const Astar::Vec update_max(changed_max[0] + range_ + 1, changed_max[1] + range_ + 1, 0);
+          as_.invalidate(update_min, update_max);
+          edge_cost_cache_.invalidate(update_min, update_max);
+        }
+        const auto tnow = boost::chrono::high_resolution_clock::now();
+        ROS_DEBUG("Hysteresis map generated (%0.4f sec.)",
+                  boost::chrono::duration<float>(tnow - ts).count());
+      }
+      if (!has_hysteresis_map_)
+      {
+        // Costs calculated without the hysteresis map lack the hysteresis term everywhere.
+        as_.invalidateAll();
+        edge_cost_cache_.invalidateAll();
+        has_hysteresis_map_ = true;
       }
-      has_hysteresis_map_ = true;
-      const auto tnow = boost::chrono::high_resolution_clock::now();
-      ROS_DEBUG("Hysteresis map generated (%0.4f sec.)",
-                boost::chrono::duration<float>(tnow - ts).count());
       publishDebug();
     }
 
@@ -1773,21 +2355,24 @@ protected:
       const std::vector<Astar::VecWithCost>& ss,
       const Astar::Vec& es)
   {
-    const float local_range_sq = local_range_ * local_range_;
+    if (!isRough(p, ss))
+      return search_list_yaw_[p[2]];
+    return search_list_rough_yaw_[p[2]];
+  }
+  // Nodes far from the starts are searched by the rough motions ignoring the yaw.
+  // Decided only by the arguments since the callbacks are called from the multiple threads.
+  bool isRough(const Astar::Vec& p, const std::vector<Astar::VecWithCost>& ss) const
+  {
+    const int local_range_sq = local_range_ * local_range_;
     for (const Astar::VecWithCost& s : ss)
     {
       const Astar::Vec ds = s.v_ - p;
-
       if (ds.sqlen() < local_range_sq)
-      {
-        rough_ = false;
-        return search_list_;
-      }
+        return false;
     }
-    rough_ = true;
-    return search_list_rough_;
+    return true;
   }
-  bool cbProgress(const std::list<Astar::Vec>& path_grid)
+  bool cbProgress(const std::vector<Astar::Vec>& path_grid)
   {
     publishEmptyPath();
     ROS_WARN("Search timed out");
@@ -1800,11 +2385,14 @@ protected:
     float cost = cost_estim_cache_[s2];
     if (cost == FLT_MAX)
       return FLT_MAX;
-    if (!rough_)
+    if (!isRough(s, search_starts_))
     {
       if (s2[2] > static_cast<int>(map_info_.angle) / 2)
         s2[2] -= map_info_.angle;
       cost += ec_[2] * fabs(s[2]);
+
+      // Both are lower bounds of the cost.
+      cost = std::max(cost, yaw_heuristic_table_.get(Astar::Vec(s[0] - e[0], s[1] - e[1], s[2]), e[2]));
     }
     return cost;
   }
@@ -1847,167 +2435,82 @@ protected:
                const Astar::Vec& v_goal,
                const bool hyst)
   {
-    Astar::Vec d_raw = e - s;
-    d_raw.cycle(map_info_.angle);
-    const Astar::Vec d = d_raw;
-    float cost = euclidCost(d);
-
-    if (d[0] == 0 && d[1] == 0)
-    {
-      // In-place turn
-      int sum = 0;
-      const int dir = d[2] < 0 ? -1 : 1;
-      Astar::Vec pos = s;
-      for (int i = 0; i < abs(d[2]); i++)
-      {
-        pos[2] += dir;
-        if (pos[2] < 0)
-          pos[2] += map_info_.angle;
-        else if (pos[2] >= static_cast<int>(map_info_.angle))
-          pos[2] -= map_info_.angle;
-        const auto c = cm_[pos];
-        if (c > 99)
-          return -1;
-        sum += c;
-      }
-
-      const float cost =
-          sum * map_info_.angular_resolution * ec_[2] / ec_[0] +
-          sum * map_info_.angular_resolution * cc_.weight_costmap_turn_ / 100.0;
-      // simplified from sum * map_info_.angular_resolution * abs(d[2]) * cc_.weight_costmap_turn_ / (100.0 * abs(d[2]))
-      return cc_.in_place_turn_ + cost;
-    }
-
-    Astar::Vec d2;
-    d2[0] = d[0] + range_;
-    d2[1] = d[1] + range_;
-    d2[2] = e[2];
-
-    const Astar::Vecf motion = rot_cache_.getMotion(s[2], d2);
-    const Astar::Vecf motion_grid = motion * resolution_;
+    Astar::Vec d = e - s;
+    d.cycle(map_info_.angle);
 
-    if (lroundf(motion_grid[0]) == 0 && lroundf(motion_grid[1]) != 0)
-    {
-      // Not non-holonomic
-      return -1;
-    }
-
-    if (fabs(motion[2]) >= 2.0 * M_PI / 4.0)
-    {
-      // Over 90 degree turn
-      // must be separated into two curves
+    // Geometric constraints and the costs depending only on the motion are precomputed.
+    const MotionPrimitive& prim = motion_primitives_[motionPrimitiveIndex(s[2], d, e[2])];
+    if (prim.type_ == MotionPrimitive::INVALID)
       return -1;
-    }
-
-    const float dist = motion.len();
-
-    if (motion[0] < 0)
-    {
-      // Going backward
-      cost *= 1.0 + cc_.weight_backward_;
-    }
-
-    if (d[2] == 0)
-    {
-      if (lroundf(motion_grid[0]) == 0)
-        return -1;  // side slip
-      const float aspect = motion[0] / motion[1];
-      if (fabs(aspect) < angle_resolution_aspect_)
-        return -1;  // large y offset
-
-      cost += ec_[2] * fabs(1.0 / aspect) * map_info_.angular_resolution / (M_PI * 2.0);
-
-      // Go-straight
-      int sum = 0, sum_hyst = 0;
-      Astar::Vec d_index(d[0], d[1], e[2]);
-      d_index.cycleUnsigned(map_info_.angle);
-
-      const auto cache_page = motion_cache_.find(s[2], d_index);
-      if (cache_page == motion_cache_.end(s[2]))
-        return -1;
-      const int num = cache_page->second.getMotion().size();
-      for (const auto& pos_diff : cache_page->second.getMotion())
-      {
-        const Astar::Vec pos(
-            s[0] + pos_diff[0], s[1] + pos_diff[1], pos_diff[2]);
-        const auto c = cm_[pos];
-        if (c > 99)
-          return -1;
-        sum += c;
 
-        if (hyst && has_hysteresis_map_)
-          sum_hyst += cm_hyst_[pos];
-      }
-      const float distf = cache_page->second.getDistance();
-      cost += sum * map_info_.linear_resolution * distf * cc_.weight_costmap_ / (100.0 * num);
-      cost += sum_hyst * map_info_.linear_resolution * distf * cc_.weight_hysteresis_ / (100.0 * num);
-    }
-    else
+    float cost;
+    if (edge_cost_cache_.find(s, prim.index_, cost))
+      return cost;
+    cost = calcEdgeCost(s, d, prim, hyst);
+    edge_cost_cache_.insert(s, prim.index_, cost);
+    return cost;
+  }
+  float calcEdgeCost(const Astar::Vec& s, const Astar::Vec& d,
+                     const MotionPrimitive& prim,
+                     const bool hyst)
+  {
+    switch (prim.type_)
     {
-      // Curve
-      if (motion[0] * motion[1] * motion[2] < 0)
-        return -1;
-
-      if (d.sqlen() < 3 * 3)
-        return -1;
-
-      const std::pair<float, float>& radiuses = rot_cache_.getRadiuses(s[2], d2);
-      const float r1 = radiuses.first;
-      const float r2 = radiuses.second;
-
-      // curveture at the start_ pose and the end pose must be same
-      if (fabs(r1 - r2) >= map_info_.linear_resolution * 1.5)
-      {
-        // Drifted
-        return -1;
-      }
-
-      const float curv_radius = (r1 + r2) / 2;
-      if (std::abs(curv_radius) < min_curve_raduis_)
+      case MotionPrimitive::INVALID:
         return -1;
-
-      // Ignore boundary
-      if (s[0] < min_boundary_[0] || s[1] < min_boundary_[1] ||
-          s[0] >= max_boundary_[0] || s[1] >= max_boundary_[1])
-        return -1;
-
-      if (fabs(max_vel_ / r1) > max_ang_vel_)
-      {
-        const float vel = fabs(curv_radius) * max_ang_vel_;
-
-        // Curve deceleration penalty
-        cost += dist * fabs(vel / max_vel_) * cc_.weight_decel_;
-      }
-
+      case MotionPrimitive::IN_PLACE_TURN:
       {
-        int sum = 0, sum_hyst = 0;
-        Astar::Vec d_index(d[0], d[1], e[2]);
-        d_index.cycleUnsigned(map_info_.angle);
-
-        const auto cache_page = motion_cache_.find(s[2], d_index);
-        if (cache_page == motion_cache_.end(s[2]))
-          return -1;
-        const int num = cache_page->second.getMotion().size();
-        for (const auto& pos_diff : cache_page->second.getMotion())
+        // In-place turn
+        int sum = 0;
+        const int dir = d[2] < 0 ? -1 : 1;
+        Astar::Vec pos = s;
+        for (int i = 0; i < abs(d[2]); i++)
         {
-          const Astar::Vec pos(
-              s[0] + pos_diff[0], s[1] + pos_diff[1], pos_diff[2]);
+          pos[2] += dir;
+          if (pos[2] < 0)
+            pos[2] += map_info_.angle;
+          else if (pos[2] >= static_cast<int>(map_info_.angle))
+            pos[2] -= map_info_.angle;
           const auto c = cm_[pos];
           if (c > 99)
             return -1;
           sum += c;
-
-          if (hyst && has_hysteresis_map_)
-            sum_hyst += cm_hyst_[pos];
         }
-        const float distf = cache_page->second.getDistance();
-        cost += sum * map_info_.linear_resolution * distf * cc_.weight_costmap_ / (100.0 * num);
-        cost += sum * map_info_.angular_resolution * abs(d[2]) * cc_.weight_costmap_turn_ / (100.0 * num);
-        cost += sum_hyst * map_info_.linear_resolution * distf * cc_.weight_hysteresis_ / (100.0 * num);
+
+        const float cost =
+            sum * map_info_.angular_resolution * ec_[2] / ec_[0] +
+            sum * map_info_.angular_resolution * cc_.weight_costmap_turn_ / 100.0;
+        // simplified from sum * map_info_.angular_resolution * abs(d[2]) * cc_.weight_costmap_turn_ / (100.0 * abs(d[2]))
+        return cc_.in_place_turn_ + cost;
       }
+      case MotionPrimitive::CURVE:
+        // Ignore boundary
+        if (s[0] < min_boundary_[0] || s[1] < min_boundary_[1] ||
+            s[0] >= max_boundary_[0] || s[1] >= max_boundary_[1])
+          return -1;
+        break;
+      case MotionPrimitive::STRAIGHT:
+        break;
     }
+    if (s[0] >= min_boundary_[0] && s[1] >= min_boundary_[1] &&
+        s[0] < max_boundary_[0] && s[1] < max_boundary_[1] &&
+        lethal_mask_.collides(s, prim.footprint_))
+      return -1;
 
-    return cost;
+    int sum = 0, sum_hyst = 0;
+    for (const auto& pos_diff : prim.page_->getMotion())
+    {
+      const Astar::Vec pos(
+          s[0] + pos_diff[0], s[1] + pos_diff[1], pos_diff[2]);
+      const auto c = cm_[pos];
+      if (c > 99)
+        return -1;
+      sum += c;
+
+      if (hyst && has_hysteresis_map_)
+        sum_hyst += cm_hyst_[pos];
+    }
+    return prim.cost_ + sum * prim.weight_costmap_ + sum_hyst * prim.weight_hysteresis_;
   }
 
   void diagnoseStatus(diagnostic_updater::DiagnosticStatusWrapper& stat)
@@ -2035,6 +2538,8 @@ protected:
     }
     stat.addf("status", "%u", status_.status);
     stat.addf("error", "%u", status_.error);
+    stat.addf("suboptimality_bound", "%0.3f", as_.getSuboptimalityBound());
+    stat.addf("expanded_nodes", "%d", static_cast<int>(as_.getExpandedNodeNum()));
   }
 };
 }  // namespace planner_3d
@@ -57,6 +57,8 @@ void RotationCache::reset(
   const int angle = std::lround(M_PI * 2 / angular_resolution);
 
   pages_.resize(angle);
+  // Pages of each start yaw are independent.
+#pragma omp parallel for schedule(dynamic)
   for (int i = 0; i < angle; i++)
   {
     Page& r = pages_[i];
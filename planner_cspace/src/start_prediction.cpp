@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <planner_cspace/cyclic_vec.h>
+#include <planner_cspace/planner_3d/start_prediction.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+float estimateLinearVelocity(
+    const CyclicVecFloat<3, 2>& prev,
+    const CyclicVecFloat<3, 2>& current,
+    const float dt)
+{
+  if (dt <= 0)
+    return 0;
+
+  const float chord = std::hypot(current[0] - prev[0], current[1] - prev[1]);
+  const float yaw_diff = std::remainder(current[2] - prev[2], 2 * M_PI);
+  const float half = std::abs(yaw_diff) / 2;
+  if (half < 1e-3)
+    return chord / dt;
+  // Length of the arc having the chord and the central angle yaw_diff.
+  return chord * half / std::sin(half) / dt;
+}
+
+bool predictPoseOnPath(
+    const std::vector<CyclicVecFloat<3, 2>>& path,
+    const CyclicVecFloat<3, 2>& start,
+    const float dist,
+    const float max_dist,
+    size_t& i_nearest,
+    size_t& i_predicted)
+{
+  // The robot must be following the path.
+  float dist_nearest_sq = FLT_MAX;
+  for (size_t i = 0; i < path.size(); ++i)
+  {
+    const float dx = path[i][0] - start[0];
+    const float dy = path[i][1] - start[1];
+    const float dist_sq = dx * dx + dy * dy;
+    if (dist_sq < dist_nearest_sq)
+    {
+      dist_nearest_sq = dist_sq;
+      i_nearest = i;
+    }
+  }
+  if (dist_nearest_sq > max_dist * max_dist)
+    return false;
+
+  // The end of the path is not predicted since the robot is expected to stop before it.
+  float traveled = 0;
+  for (size_t i = i_nearest; i + 1 < path.size(); ++i)
+  {
+    if (traveled >= dist)
+    {
+      i_predicted = i;
+      return true;
+    }
+    traveled += std::hypot(path[i + 1][0] - path[i][0], path[i + 1][1] - path[i][1]);
+  }
+  return false;
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include <planner_cspace/planner_3d/yaw_heuristic_table.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+YawHeuristicTable::YawHeuristicTable()
+  : angle_(0)
+  , range_(0)
+  , motion_range_(0)
+  , euclid_cost_lin_(0)
+{
+}
+
+void YawHeuristicTable::reset(
+    const int angle, const int range, const int motion_range, const float euclid_cost_lin)
+{
+  angle_ = angle;
+  range_ = range;
+  motion_range_ = motion_range;
+  euclid_cost_lin_ = euclid_cost_lin;
+  motions_.clear();
+  motions_.resize(angle);
+  motions_reverse_.clear();
+  motions_reverse_.resize(angle);
+  tables_.clear();
+  tables_.resize(angle);
+}
+
+void YawHeuristicTable::addMotion(const int start_yaw, const Vec& d, const float cost)
+{
+  motions_[start_yaw].emplace_back(d, cost);
+  motions_reverse_[d[2]].emplace_back(Vec(d[0], d[1], start_yaw), cost);
+}
+
+void YawHeuristicTable::create(const int goal_yaw)
+{
+  const int width = range_ * 2 + 1;
+  std::vector<float>& table = tables_[goal_yaw];
+  table.assign(static_cast<size_t>(width) * width * angle_, FLT_MAX);
+
+  // The cost from the outside of the table is bounded by the euclid distance to the goal.
+  Vec d;
+  for (d[0] = -range_; d[0] <= range_; ++d[0])
+  {
+    for (d[1] = -range_; d[1] <= range_; ++d[1])
+    {
+      if (std::abs(d[0]) <= range_ - motion_range_ &&
+          std::abs(d[1]) <= range_ - motion_range_)
+        continue;
+      for (d[2] = 0; d[2] < angle_; ++d[2])
+      {
+        float& cost = table[index(d)];
+        for (const Motion& m : motions_[d[2]])
+        {
+          const Vec next(d[0] + m.d_[0], d[1] + m.d_[1], m.d_[2]);
+          if (inside(next))
+            continue;
+          const int rootsum = next[0] * next[0] + next[1] * next[1];
+          cost = std::min(cost, m.cost_ + sqrtf(rootsum) * euclid_cost_lin_);
+        }
+      }
+    }
+  }
+
+  using Node = std::pair<float, size_t>;
+  std::priority_queue<Node, std::vector<Node>, std::greater<Node>> open;
+  table[index(Vec(0, 0, goal_yaw))] = 0;
+  for (size_t i = 0; i < table.size(); ++i)
+  {
+    if (table[i] != FLT_MAX)
+      open.emplace(table[i], i);
+  }
+  while (!open.empty())
+  {
+    const Node node = open.top();
+    open.pop();
+    if (node.first > table[node.second])
+      continue;
+    const Vec p(
+        static_cast<int>(node.second / angle_ / width) - range_,
+        static_cast<int>(node.second / angle_ % width) - range_,
+        static_cast<int>(node.second % angle_));
+    for (const Motion& m : motions_reverse_[p[2]])
+    {
+      const Vec prev(p[0] - m.d_[0], p[1] - m.d_[1], m.d_[2]);
+      if (!inside(prev))
+        continue;
+      const size_t i = index(prev);
+      const float cost = node.first + m.cost_;
+      if (cost < table[i])
+      {
+        table[i] = cost;
+        open.emplace(cost, i);
+      }
+    }
+  }
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
@@ -150,6 +150,149 @@ TEST(BlockmemGridmap, OuterBoundary)
   }
 }
 
+TEST(BlockmemGridmap, AddressPosition)
+{
+  BlockMemGridmap<float, 3, 2, 0x20> gm;
+
+  const int s[3] = { 0x30, 0x50, 0x10 };
+  gm.reset(CyclicVecInt<3, 2>(s[0], s[1], s[2]));
+
+  CyclicVecInt<3, 2> i;
+  for (i[0] = 0; i[0] < s[0]; ++i[0])
+  {
+    for (i[1] = 0; i[1] < s[1]; ++i[1])
+    {
+      for (i[2] = 0; i[2] < s[2]; ++i[2])
+      {
+        const size_t addr = gm.address(i);
+        ASSERT_LT(addr, gm.ser_size());
+        ASSERT_EQ(i, gm.position(addr));
+      }
+    }
+  }
+}
+
+TEST(BlockmemGridmap, EpochClear)
+{
+  EpochBlockMemGridmap<float, 3, 2, 0x20> gm;
+
+  const int s = 0x30;
+  gm.reset(CyclicVecInt<3, 2>(s, s, 4));
+  gm.clear(1.0);
+
+  const CyclicVecInt<3, 2> p0(3, 5, 1);
+  const CyclicVecInt<3, 2> p1(0x21, 0x2F, 3);
+  gm[p0] = 10.0;
+  ASSERT_EQ(10.0, gm[p0]);
+  ASSERT_EQ(1.0, gm[p1]);
+
+  gm.clear(2.0);
+  const EpochBlockMemGridmap<float, 3, 2, 0x20>& gm_const = gm;
+  // Stale cells must be read as the cleared value without writing
+  ASSERT_EQ(2.0, gm_const[p0]);
+  ASSERT_EQ(2.0, gm_const[p1]);
+
+  gm[p1] += 1.0;
+  ASSERT_EQ(2.0, gm[p0]);
+  ASSERT_EQ(3.0, gm[p1]);
+
+  gm[p0] = -1.0;
+  gm.clear_positive(4.0);
+  ASSERT_EQ(-1.0, gm[p0]);
+  ASSERT_EQ(4.0, gm[p1]);
+
+  EpochBlockMemGridmap<float, 3, 2, 0x20> gm_copy;
+  gm_copy = gm;
+  ASSERT_EQ(-1.0, gm_copy[p0]);
+  ASSERT_EQ(4.0, gm_copy[p1]);
+  const CyclicVecInt<3, 2> p2(0, 0, 0);
+  ASSERT_EQ(4.0, gm_copy[p2]);
+}
+
+TEST(BlockmemGridmap, Copy)
+{
+  BlockMemGridmap<float, 3, 2, 0x20> gm;
+  BlockMemGridmap<float, 3, 2, 0x20> gm_copy;
+
+  const int s = 0x30;
+  gm.reset(CyclicVecInt<3, 2>(s, s, 4));
+  CyclicVecInt<3, 2> i;
+  for (i[0] = 0; i[0] < s; ++i[0])
+  {
+    for (i[1] = 0; i[1] < s; ++i[1])
+    {
+      for (i[2] = 0; i[2] < 4; ++i[2])
+      {
+        gm[i] = i[2] * 10000 + i[1] * 100 + i[0];
+      }
+    }
+  }
+  gm_copy = gm;
+  for (i[0] = 0; i[0] < s; ++i[0])
+  {
+    for (i[1] = 0; i[1] < s; ++i[1])
+    {
+      for (i[2] = 0; i[2] < 4; ++i[2])
+      {
+        ASSERT_EQ(gm[i], gm_copy[i]);
+      }
+    }
+  }
+}
+
+TEST(BlockmemGridmap, OverlayRestore)
+{
+  using Vec = CyclicVecInt<3, 2>;
+  BlockMemGridmap<float, 3, 2, 0x10> gm_base;
+  OverlayBlockMemGridmap<float, 3, 2, 0x10> gm;
+
+  const int s = 0x40;
+  gm_base.reset(Vec(s, s, 2));
+  gm_base.clear(1.0);
+  gm = gm_base;
+  ASSERT_EQ(0u, gm.dirtyBlockNum());
+
+  // Window over 2x3 blocks
+  const Vec min(0x0C, 0x08, 0);
+  const Vec max(0x14, 0x24, 0);
+  gm.markDirty(min, max);
+  ASSERT_EQ(6u, gm.dirtyBlockNum());
+  gm.markDirty(min, max);
+  ASSERT_EQ(6u, gm.dirtyBlockNum());
+
+  Vec i;
+  for (i[0] = min[0]; i[0] < max[0]; ++i[0])
+  {
+    for (i[1] = min[1]; i[1] < max[1]; ++i[1])
+    {
+      for (i[2] = 0; i[2] < 2; ++i[2])
+      {
+        gm[i] = 5.0;
+      }
+    }
+  }
+  ASSERT_EQ(5.0, gm[min]);
+
+  gm.restore(gm_base);
+  ASSERT_EQ(0u, gm.dirtyBlockNum());
+  for (i[0] = 0; i[0] < s; ++i[0])
+  {
+    for (i[1] = 0; i[1] < s; ++i[1])
+    {
+      for (i[2] = 0; i[2] < 2; ++i[2])
+      {
+        ASSERT_EQ(1.0, gm[i]);
+      }
+    }
+  }
+
+  // Out of the map
+  gm.markDirty(Vec(-0x10, -0x10, 0), Vec(0, 0, 0));
+  ASSERT_EQ(0u, gm.dirtyBlockNum());
+  gm.markDirty(Vec(s - 1, s - 1, 0), Vec(s + 0x10, s + 0x10, 0));
+  ASSERT_EQ(1u, gm.dirtyBlockNum());
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -27,6 +27,8 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <array>
+#include <cfloat>
 #include <cstddef>
 
 #include <gtest/gtest.h>
@@ -85,8 +87,8 @@ TEST(BlockmemGridmap, SpacialAccessPerformance)
       }
     }
   }
-  boost::chrono::duration<float> d0;
-  boost::chrono::duration<float> d1;
+  boost::chrono::duration<float> d0(0);
+  boost::chrono::duration<float> d1(0);
 
   for (int r = 0; r < repeat; ++r)
   {
@@ -172,6 +174,77 @@ TEST(BlockmemGridmap, SpacialAccessPerformance)
   ASSERT_LT(d0, d1);
 }
 
+TEST(BlockmemGridmap, ClearPerformance)
+{
+  constexpr int size[3] =
+      {
+        0x400, 0x400, 0x10
+      };
+  constexpr int range = 0x20;
+  constexpr int repeat = 0x40;
+
+  BlockMemGridmap<float, 3, 2, 0x20> gm;
+  EpochBlockMemGridmap<float, 3, 2, 0x20> gm_epoch;
+
+  using Vec = CyclicVecInt<3, 2>;
+  gm.reset(Vec(size[0], size[1], size[2]));
+  gm_epoch.reset(Vec(size[0], size[1], size[2]));
+
+  boost::chrono::duration<float> d0(0);
+  boost::chrono::duration<float> d1(0);
+  float sum0 = 0;
+  float sum1 = 0;
+
+  for (int r = 0; r < repeat; ++r)
+  {
+    // Clear and touch small area like a search to the nearby goal.
+    const Vec center(size[0] / 2 + r, size[1] / 2 - r, 0);
+    Vec i;
+
+    const auto ts0 = boost::chrono::high_resolution_clock::now();
+    gm.clear(FLT_MAX);
+    for (i[0] = center[0] - range; i[0] < center[0] + range; ++i[0])
+    {
+      for (i[1] = center[1] - range; i[1] < center[1] + range; ++i[1])
+      {
+        for (i[2] = 0; i[2] < size[2]; ++i[2])
+        {
+          if (gm[i] > r)
+            gm[i] = r;
+          sum0 += gm[i];
+        }
+      }
+    }
+    const auto te0 = boost::chrono::high_resolution_clock::now();
+    d0 += boost::chrono::duration<float>(te0 - ts0);
+
+    const auto ts1 = boost::chrono::high_resolution_clock::now();
+    gm_epoch.clear(FLT_MAX);
+    for (i[0] = center[0] - range; i[0] < center[0] + range; ++i[0])
+    {
+      for (i[1] = center[1] - range; i[1] < center[1] + range; ++i[1])
+      {
+        for (i[2] = 0; i[2] < size[2]; ++i[2])
+        {
+          if (gm_epoch[i] > r)
+            gm_epoch[i] = r;
+          sum1 += gm_epoch[i];
+        }
+      }
+    }
+    const auto te1 = boost::chrono::high_resolution_clock::now();
+    d1 += boost::chrono::duration<float>(te1 - ts1);
+  }
+  std::cout << "BlockMemGridmap<3, 2>: " << d0.count() << std::endl;
+  std::cout << "EpochBlockMemGridmap<3, 2>: " << d1.count() << std::endl;
+
+  ASSERT_EQ(sum0, sum1);
+
+  // Compare performance.
+  std::cout << "Improvement ratio: " << d0.count() / d1.count() << std::endl;
+  ASSERT_LT(d1, d0);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include <gtest/gtest.h>
+
+#include <planner_cspace/blockmem_gridmap.h>
+#include <planner_cspace/planner_3d/costmap_update.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+TEST(CostmapUpdatePerformance, Merge)
+{
+  using Vec = CyclicVecInt<3, 2>;
+  using Gridmap = BlockMemGridmap<char, 3, 2, 0x40>;
+  // 8m x 8m update of 5cm resolution on 51.2m x 51.2m map.
+  const Vec map_size(0x400, 0x400, 16);
+  const Vec update_size(160, 160, 16);
+  const Vec update_pos(300, 400, 0);
+  constexpr int repeat = 20;
+
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<int> dist(-1, 100);
+  std::vector<int8_t> data(update_size[0] * update_size[1] * update_size[2]);
+  Gridmap gm_base(map_size);
+  Gridmap gm_ref;
+  Gridmap gm;
+  for (size_t i = 0; i < gm_base.ser_size(); ++i)
+    gm_base[i] = dist(engine);
+
+  for (const bool overwrite : {false, true})
+  {
+    boost::chrono::duration<float> d_ref(0);
+    boost::chrono::duration<float> d(0);
+    for (int r = 0; r < repeat; ++r)
+    {
+      for (int8_t& c : data)
+        c = dist(engine);
+      gm_ref = gm_base;
+      gm = gm_base;
+
+      // Per cell merge.
+      std::vector<int> cost_min_ref(update_size[0] * update_size[1], 100);
+      const auto ts_ref = boost::chrono::high_resolution_clock::now();
+      for (Vec p(0, 0, 0); p[0] < update_size[0]; p[0]++)
+      {
+        for (p[1] = 0; p[1] < update_size[1]; p[1]++)
+        {
+          int& cost_min = cost_min_ref[p[1] * update_size[0] + p[0]];
+          for (p[2] = 0; p[2] < update_size[2]; p[2]++)
+          {
+            const size_t addr = ((p[2] * update_size[1]) + p[1]) * update_size[0] + p[0];
+            const char c = data[addr];
+            if (c < cost_min)
+              cost_min = c;
+          }
+          for (p[2] = 0; p[2] < update_size[2]; p[2]++)
+          {
+            const size_t addr = ((p[2] * update_size[1]) + p[1]) * update_size[0] + p[0];
+            const char c = data[addr];
+            if (overwrite)
+            {
+              if (c >= 0)
+                gm_ref[update_pos + p] = c;
+            }
+            else
+            {
+              if (gm_ref[update_pos + p] < c)
+                gm_ref[update_pos + p] = c;
+            }
+          }
+        }
+      }
+      const auto te_ref = boost::chrono::high_resolution_clock::now();
+      d_ref += te_ref - ts_ref;
+
+      std::vector<int> cost_min(update_size[0] * update_size[1], 100);
+      const auto ts = boost::chrono::high_resolution_clock::now();
+      mergeCostmapUpdate(
+          gm, update_pos, update_size, data.data(), overwrite,
+          [&cost_min, &update_pos, &update_size](const Vec& p, const char* column)
+          {
+            int& c = cost_min[(p[1] - update_pos[1]) * update_size[0] + p[0] - update_pos[0]];
+            for (int yaw = 0; yaw < update_size[2]; ++yaw)
+              c = std::min(c, static_cast<int>(column[yaw]));
+          });
+      const auto te = boost::chrono::high_resolution_clock::now();
+      d += te - ts;
+
+      ASSERT_EQ(cost_min_ref, cost_min);
+      for (size_t i = 0; i < gm.ser_size(); ++i)
+      {
+        if (gm_ref[i] != gm[i])
+        {
+          ASSERT_EQ(gm_ref[i], gm[i]) << "overwrite: " << overwrite << ", address: " << i;
+        }
+      }
+    }
+    std::cout << "overwrite: " << overwrite << std::endl;
+    std::cout << "  Per cell merge: " << d_ref.count() / repeat << " sec." << std::endl;
+    std::cout << "  Block merge: " << d.count() / repeat << " sec." << std::endl;
+    EXPECT_LT(d, d_ref);
+  }
+}
+
+TEST(CostmapUpdatePerformance, Import)
+{
+  using Vec = CyclicVecInt<3, 2>;
+  using Gridmap = BlockMemGridmap<char, 3, 2, 0x40>;
+  using GridmapRough = BlockMemGridmap<char, 3, 2, 0x80>;
+  const Vec map_size(0x400, 0x380, 16);
+  const char unknown_cost = 50;
+  constexpr int repeat = 4;
+
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<int> dist(-1, 100);
+  std::vector<int8_t> data(map_size[0] * map_size[1] * map_size[2]);
+  for (int8_t& c : data)
+    c = dist(engine);
+
+  Gridmap gm_ref(map_size);
+  Gridmap gm(map_size);
+  GridmapRough gm_rough_ref(Vec(map_size[0], map_size[1], 1));
+  GridmapRough gm_rough(Vec(map_size[0], map_size[1], 1));
+
+  boost::chrono::duration<float> d_ref(0);
+  boost::chrono::duration<float> d(0);
+  for (int r = 0; r < repeat; ++r)
+  {
+    // Per cell import.
+    const auto ts_ref = boost::chrono::high_resolution_clock::now();
+    Vec p;
+    for (p[0] = 0; p[0] < map_size[0]; p[0]++)
+    {
+      for (p[1] = 0; p[1] < map_size[1]; p[1]++)
+      {
+        int cost_min = 100;
+        for (p[2] = 0; p[2] < map_size[2]; p[2]++)
+        {
+          const size_t addr = ((p[2] * map_size[1]) + p[1]) * map_size[0] + p[0];
+          char c = data[addr];
+          if (c < 0)
+            c = unknown_cost;
+          gm_ref[p] = c;
+          if (c < cost_min)
+            cost_min = c;
+        }
+        p[2] = 0;
+        gm_rough_ref[p] = cost_min;
+      }
+    }
+    const auto te_ref = boost::chrono::high_resolution_clock::now();
+    d_ref += te_ref - ts_ref;
+
+    const auto ts = boost::chrono::high_resolution_clock::now();
+    importCostmap(
+        gm, data.data(), unknown_cost,
+        [&gm_rough, &map_size](const Vec& p, const char* column)
+        {
+          int cost_min = 100;
+          for (int yaw = 0; yaw < map_size[2]; ++yaw)
+            cost_min = std::min(cost_min, static_cast<int>(column[yaw]));
+          gm_rough[Vec(p[0], p[1], 0)] = cost_min;
+        });
+    const auto te = boost::chrono::high_resolution_clock::now();
+    d += te - ts;
+  }
+  Vec p;
+  for (p[0] = 0; p[0] < map_size[0]; p[0]++)
+  {
+    for (p[1] = 0; p[1] < map_size[1]; p[1]++)
+    {
+      for (p[2] = 0; p[2] < map_size[2]; p[2]++)
+      {
+        if (gm_ref[p] != gm[p])
+        {
+          ASSERT_EQ(gm_ref[p], gm[p]) << p[0] << ", " << p[1] << ", " << p[2];
+        }
+      }
+      p[2] = 0;
+      ASSERT_EQ(gm_rough_ref[p], gm_rough[p]) << p[0] << ", " << p[1];
+    }
+  }
+  std::cout << "Per cell import: " << d_ref.count() / repeat << " sec." << std::endl;
+  std::cout << "Block import: " << d.count() / repeat << " sec." << std::endl;
+  EXPECT_LT(d, d_ref);
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <omp.h>
+
+#include <planner_cspace/planner_3d/costmap_bbf.h>
+#include <planner_cspace/planner_3d/distance_map.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+namespace
+{
+using Vec = DistanceMap::Vec;
+
+// Serial Dijkstra with the same cost model.
+void fillReference(
+    const DistanceMap::Costmap& cm,
+    const DistanceMap::Params& p,
+    DistanceMap::Gridmap& g,
+    const std::vector<Vec>& seeds)
+{
+  using Node = std::pair<float, Vec>;
+  const auto cmp = [](const Node& a, const Node& b)
+  {
+    return a.first > b.first;
+  };
+  std::priority_queue<Node, std::vector<Node>, decltype(cmp)> open(cmp);
+  for (const Vec& s : seeds)
+    open.emplace(g[s], s);
+
+  while (!open.empty())
+  {
+    const Node n = open.top();
+    open.pop();
+    if (n.first > g[n.second])
+      continue;
+    Vec d(0, 0, 0);
+    for (d[0] = -4; d[0] <= 4; d[0]++)
+    {
+      for (d[1] = -4; d[1] <= 4; d[1]++)
+      {
+        if ((d[0] == 0 && d[1] == 0) || d.sqlen() > 4 * 4)
+          continue;
+        const Vec next = n.second + d;
+        if (next[0] < 0 || next[1] < 0 || next[0] >= cm.size()[0] || next[1] >= cm.size()[1])
+          continue;
+        const int dist = d.len();
+        CyclicVecFloat<3, 2> pos(0, 0, 0);
+        float sum = 0;
+        bool collision = false;
+        Vec prev(-1, -1, -1);
+        for (int i = 0; i < dist; i++)
+        {
+          const Vec ipos(pos);
+          pos[0] += static_cast<float>(d[0]) / dist;
+          pos[1] += static_cast<float>(d[1]) / dist;
+          if (ipos == prev)
+            continue;
+          prev = ipos;
+          const char c = cm[n.second + ipos];
+          if (c > 99)
+          {
+            collision = true;
+            break;
+          }
+          sum += c;
+        }
+        if (collision)
+          continue;
+        const float cost =
+            sqrtf(d.sqlen()) * p.euclid_cost +
+            (p.resolution * d.gridToLenFactor() / 100.0) * (sum * p.weight_costmap);
+        if (g[next] > n.first + cost)
+        {
+          g[next] = n.first + cost;
+          open.emplace(g[next], next);
+        }
+      }
+    }
+  }
+}
+}  // namespace
+
+TEST(DistanceMap, Fill)
+{
+  const Vec size(96, 64, 1);
+  DistanceMap::Costmap cm;
+  cm.reset(size);
+  CostmapBBF bbf;
+  bbf.reset(size);
+  bbf.clear();
+
+  // Random costs and walls with gaps
+  srand(1);
+  for (Vec p(0, 0, 0); p[1] < size[1]; p[1]++)
+  {
+    for (p[0] = 0; p[0] < size[0]; p[0]++)
+    {
+      cm[p] = rand() % 50;
+      if ((p[0] == 32 && p[1] > 8) || (p[0] == 64 && p[1] < 56))
+        cm[p] = 100;
+    }
+  }
+
+  const DistanceMap::Params params = {3.3f, 0.05f, 50.0f, 1000.0f};
+  DistanceMap dm(cm, bbf);
+  dm.setParams(params);
+
+  for (const int threads : {1, 4})
+  {
+    omp_set_num_threads(threads);
+
+    const std::vector<Vec> seeds = {Vec(90, 60, 0), Vec(80, 2, 0)};
+    DistanceMap::Gridmap g;
+    DistanceMap::Gridmap g_ref;
+    g.reset(size);
+    g_ref.reset(size);
+    g.clear(FLT_MAX);
+    g_ref.clear(FLT_MAX);
+    g[seeds[0]] = g_ref[seeds[0]] = -1.0f;
+    g[seeds[1]] = g_ref[seeds[1]] = 20.0f;
+
+    dm.fill(g, seeds, Vec(2, 2, 0), FLT_MAX);
+    fillReference(cm, params, g_ref, seeds);
+
+    for (Vec p(0, 0, 0); p[1] < size[1]; p[1]++)
+    {
+      for (p[0] = 0; p[0] < size[0]; p[0]++)
+      {
+        if (g_ref[p] == FLT_MAX)
+          ASSERT_EQ(FLT_MAX, g[p]);
+        else
+          ASSERT_NEAR(g_ref[p], g[p], std::abs(g_ref[p]) * 1e-5) << p[0] << ", " << p[1];
+      }
+    }
+
+    // Cells far from the start are not expanded.
+    DistanceMap::Gridmap g_limited;
+    g_limited.reset(size);
+    g_limited.clear(FLT_MAX);
+    g_limited[seeds[0]] = -1.0f;
+    dm.fill(g_limited, {seeds[0]}, Vec(88, 60, 0), 10.0f);
+    ASSERT_NEAR(g_ref[Vec(88, 60, 0)], g_limited[Vec(88, 60, 0)], 1e-3);
+    ASSERT_EQ(FLT_MAX, g_limited[Vec(2, 2, 0)]);
+  }
+}
+
+TEST(DistanceMap, Update)
+{
+  const Vec size(96, 64, 1);
+  DistanceMap::Costmap cm;
+  cm.reset(size);
+  CostmapBBF bbf;
+  bbf.reset(size);
+  bbf.clear();
+
+  srand(2);
+  for (Vec p(0, 0, 0); p[1] < size[1]; p[1]++)
+  {
+    for (p[0] = 0; p[0] < size[0]; p[0]++)
+    {
+      cm[p] = rand() % 50;
+      if (p[0] == 48 && p[1] > 16)
+        cm[p] = 100;
+    }
+  }
+  const DistanceMap::Params params = {3.3f, 0.05f, 50.0f, 1000.0f};
+  DistanceMap dm(cm, bbf);
+  dm.setParams(params);
+
+  const Vec e(90, 60, 0);
+  DistanceMap::Gridmap g;
+  g.reset(size);
+  g.clear(FLT_MAX);
+  g[e] = 0;
+  // Propagation is stopped around the start first.
+  dm.fill(g, {e}, Vec(70, 50, 0), 10.0f);
+  ASSERT_EQ(FLT_MAX, g[Vec(2, 60, 0)]);
+
+  const auto check = [&]()
+  {
+    DistanceMap::Gridmap g_ref;
+    g_ref.reset(size);
+    g_ref.clear(FLT_MAX);
+    g_ref[e] = 0;
+    fillReference(cm, params, g_ref, {e});
+    for (Vec p(0, 0, 0); p[1] < size[1]; p[1]++)
+    {
+      for (p[0] = 0; p[0] < size[0]; p[0]++)
+      {
+        if (g_ref[p] == FLT_MAX)
+          ASSERT_EQ(FLT_MAX, g[p]);
+        else
+          ASSERT_NEAR(g_ref[p], g[p], std::abs(g_ref[p]) * 1e-5) << p[0] << ", " << p[1];
+      }
+    }
+  };
+
+  // Block the gap of the wall. Pending cells are propagated to the start moved far.
+  for (Vec p(48, 0, 0); p[1] < 17; p[1]++)
+    cm[p] = 100;
+  dm.update(g, Vec(48, 0, 0), Vec(49, 17, 0), Vec(2, 60, 0), FLT_MAX);
+  check();
+
+  // Open another gap
+  for (Vec p(48, 40, 0); p[1] < 44; p[1]++)
+    cm[p] = 0;
+  dm.update(g, Vec(48, 40, 0), Vec(49, 44, 0), Vec(2, 60, 0), FLT_MAX);
+  check();
+
+  // Increase and decrease the costs
+  for (Vec p(60, 20, 0); p[1] < 30; p[1]++)
+  {
+    for (p[0] = 60; p[0] < 70; p[0]++)
+      cm[p] = p[0] < 65 ? 99 : 0;
+  }
+  dm.update(g, Vec(60, 20, 0), Vec(70, 30, 0), Vec(2, 60, 0), FLT_MAX);
+  check();
+}
+
+TEST(DistanceMap, RestoreState)
+{
+  const Vec size(96, 64, 1);
+  DistanceMap::Costmap cm;
+  cm.reset(size);
+  CostmapBBF bbf;
+  bbf.reset(size);
+  bbf.clear();
+
+  srand(3);
+  for (Vec p(0, 0, 0); p[1] < size[1]; p[1]++)
+  {
+    for (p[0] = 0; p[0] < size[0]; p[0]++)
+    {
+      cm[p] = rand() % 50;
+      if (p[0] == 48 && p[1] > 16)
+        cm[p] = 100;
+    }
+  }
+  const DistanceMap::Params params = {3.3f, 0.05f, 50.0f, 1000.0f};
+  DistanceMap dm(cm, bbf);
+  dm.setParams(params);
+
+  const Vec s(2, 30, 0);
+  const Vec e0(90, 60, 0);
+  const Vec e1(80, 4, 0);
+  DistanceMap::Gridmap g0;
+  g0.reset(size);
+  g0.clear(FLT_MAX);
+  g0[e0] = 0;
+  dm.fill(g0, {e0}, s, FLT_MAX);
+  DistanceMap::Gridmap g0_stored;
+  g0_stored = g0;
+  DistanceMap::State state0;
+  state0 = dm.getState();
+
+  // Use the other goal while the costmap is changed in two regions.
+  DistanceMap::Gridmap g1;
+  g1.reset(size);
+  g1.clear(FLT_MAX);
+  g1[e1] = 0;
+  dm.fill(g1, {e1}, s, FLT_MAX);
+
+  for (Vec p(48, 0, 0); p[1] < 17; p[1]++)
+    cm[p] = 100;
+  for (Vec p(48, 40, 0); p[1] < 44; p[1]++)
+    cm[p] = 0;
+  const std::vector<DistanceMap::Region> changed =
+      {
+        DistanceMap::Region(Vec(48, 0, 0), Vec(49, 17, 0)),
+        DistanceMap::Region(Vec(48, 40, 0), Vec(49, 44, 0)),
+      };
+
+  // Repair the stored field of the first goal.
+  DistanceMap::Gridmap g;
+  g = g0_stored;
+  dm.setState(state0);
+  dm.update(g, changed, s, FLT_MAX);
+
+  DistanceMap::Gridmap g_ref;
+  g_ref.reset(size);
+  g_ref.clear(FLT_MAX);
+  g_ref[e0] = 0;
+  fillReference(cm, params, g_ref, {e0});
+  for (Vec p(0, 0, 0); p[1] < size[1]; p[1]++)
+  {
+    for (p[0] = 0; p[0] < size[0]; p[0]++)
+    {
+      if (g_ref[p] == FLT_MAX)
+        ASSERT_EQ(FLT_MAX, g[p]);
+      else
+        ASSERT_NEAR(g_ref[p], g[p], std::abs(g_ref[p]) * 1e-5) << p[0] << ", " << p[1];
+    }
+  }
+
+  // The field stored with the propagation stopped around the previous start
+  // is propagated to the current start even without costmap changes.
+  DistanceMap::Gridmap g2;
+  g2.reset(size);
+  g2.clear(FLT_MAX);
+  g2[e0] = 0;
+  dm.fill(g2, {e0}, Vec(70, 50, 0), 10.0f);
+  ASSERT_EQ(FLT_MAX, g2[s]);
+  DistanceMap::State state2;
+  state2 = dm.getState();
+  dm.fill(g1, {e1}, s, FLT_MAX);
+
+  dm.setState(state2);
+  dm.update(g2, {}, s, FLT_MAX);
+  for (Vec p(0, 0, 0); p[1] < size[1]; p[1]++)
+  {
+    for (p[0] = 0; p[0] < size[0]; p[0]++)
+    {
+      if (g_ref[p] == FLT_MAX)
+        ASSERT_EQ(FLT_MAX, g2[p]);
+      else
+        ASSERT_NEAR(g_ref[p], g2[p], std::abs(g_ref[p]) * 1e-5) << p[0] << ", " << p[1];
+    }
+  }
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstddef>
+
+#include <gtest/gtest.h>
+
+#include <planner_cspace/planner_3d/edge_cost_cache.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+TEST(EdgeCostCache, FindInsert)
+{
+  using Vec = EdgeCostCache::Vec;
+  EdgeCostCache cache;
+  cache.reset(Vec(40, 30, 4), 10, 1024 * 1024);
+  ASSERT_TRUE(cache.enabled());
+
+  float cost;
+  ASSERT_FALSE(cache.find(Vec(3, 4, 1), 5, cost));
+  cache.insert(Vec(3, 4, 1), 5, 1.5f);
+  cache.insert(Vec(3, 4, 1), 6, -1.0f);
+  cache.insert(Vec(39, 29, 3), 9, 2.5f);
+  ASSERT_TRUE(cache.find(Vec(3, 4, 1), 5, cost));
+  ASSERT_EQ(1.5f, cost);
+  ASSERT_TRUE(cache.find(Vec(3, 4, 1), 6, cost));
+  ASSERT_EQ(-1.0f, cost);
+  ASSERT_TRUE(cache.find(Vec(39, 29, 3), 9, cost));
+  ASSERT_EQ(2.5f, cost);
+  ASSERT_FALSE(cache.find(Vec(3, 4, 2), 5, cost));
+  ASSERT_FALSE(cache.find(Vec(4, 4, 1), 5, cost));
+  ASSERT_FALSE(cache.find(Vec(3, 4, 1), 4, cost));
+  ASSERT_GT(cache.memoryUsed(), 0u);
+
+  // Only the blocks overlapping the region are dropped.
+  cache.invalidate(Vec(10, 10, 0), Vec(20, 20, 0));
+  ASSERT_TRUE(cache.find(Vec(3, 4, 1), 5, cost));
+  ASSERT_TRUE(cache.find(Vec(39, 29, 3), 9, cost));
+  cache.invalidate(Vec(38, 28, 0), Vec(50, 50, 0));
+  ASSERT_TRUE(cache.find(Vec(3, 4, 1), 5, cost));
+  ASSERT_FALSE(cache.find(Vec(39, 29, 3), 9, cost));
+
+  cache.invalidateAll();
+  ASSERT_FALSE(cache.find(Vec(3, 4, 1), 5, cost));
+  ASSERT_EQ(0u, cache.memoryUsed());
+}
+
+TEST(EdgeCostCache, MemoryLimit)
+{
+  using Vec = EdgeCostCache::Vec;
+  EdgeCostCache cache;
+  const size_t block_mem = 8 * 8 * 4 * 10 * sizeof(float);
+
+  cache.reset(Vec(40, 30, 4), 10, block_mem - 1);
+  ASSERT_FALSE(cache.enabled());
+  float cost;
+  cache.insert(Vec(3, 4, 1), 5, 1.5f);
+  ASSERT_FALSE(cache.find(Vec(3, 4, 1), 5, cost));
+
+  // Only one block can be allocated.
+  cache.reset(Vec(40, 30, 4), 10, block_mem * 3 / 2);
+  ASSERT_TRUE(cache.enabled());
+  cache.insert(Vec(3, 4, 1), 5, 1.5f);
+  cache.insert(Vec(20, 20, 1), 5, 2.5f);
+  ASSERT_TRUE(cache.find(Vec(3, 4, 1), 5, cost));
+  ASSERT_FALSE(cache.find(Vec(20, 20, 1), 5, cost));
+  ASSERT_EQ(block_mem, cache.memoryUsed());
+
+  // Released memory is reused.
+  cache.invalidate(Vec(0, 0, 0), Vec(1, 1, 0));
+  cache.insert(Vec(20, 20, 1), 5, 2.5f);
+  ASSERT_TRUE(cache.find(Vec(20, 20, 1), 5, cost));
+  ASSERT_EQ(2.5f, cost);
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
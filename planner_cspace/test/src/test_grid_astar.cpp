@@ -27,7 +27,9 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <list>
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
 #include <vector>
 
 #include <boost/thread.hpp>
@@ -75,14 +77,14 @@ TEST(GridAstar, ParallelSearch)
   {
     return search[p[0]];
   };
-  const auto cb_progress = [](const std::list<Vec>&)
+  const auto cb_progress = [](const std::vector<Vec>&)
   {
     return true;
   };
 
   for (int i = 0; i < 1000; ++i)
   {
-    std::list<Vec> path;
+    std::vector<Vec> path;
     ASSERT_TRUE(
         as.search(
             Vec(0), Vec(15), path,
@@ -94,6 +96,507 @@ TEST(GridAstar, ParallelSearch)
   }
 }
 
+TEST(GridAstar, HashDistributedSearch)
+{
+  using Vec = CyclicVecInt<2, 2>;
+  const Vec size(32, 32);
+  omp_set_num_threads(4);
+
+  // Wall with a gap at the top
+  const auto cb_cost = [](
+      const Vec& s, const Vec& e, const Vec&, const Vec&) -> float
+  {
+    if (e[0] == 16 && e[1] < 28)
+      return -1;
+    return (e - s).len();
+  };
+  const auto cb_cost_estim = [](const Vec& s, const Vec& e) -> float
+  {
+    return (e - s).len();
+  };
+  std::vector<Vec> search;
+  for (int x = -1; x <= 1; ++x)
+  {
+    for (int y = -1; y <= 1; ++y)
+    {
+      if (x == 0 && y == 0)
+        continue;
+      search.push_back(Vec(x, y));
+    }
+  }
+  const auto cb_search = [&search](
+      const Vec&, const Vec&, const Vec&) -> std::vector<Vec>&
+  {
+    return search;
+  };
+  const auto cb_progress = [](const std::vector<Vec>&)
+  {
+    return true;
+  };
+  const auto path_cost = [](const std::vector<Vec>& path)
+  {
+    float cost = 0;
+    for (auto it = std::next(path.begin()); it != path.end(); ++it)
+      cost += (*it - *std::prev(it)).len();
+    return cost;
+  };
+
+  GridAstar<2, 2> as_ref(size);
+  as_ref.setSearchTaskNum(1);
+  std::vector<Vec> path_ref;
+  ASSERT_TRUE(
+      as_ref.search(
+          Vec(2, 2), Vec(30, 2), path_ref,
+          cb_cost, cb_cost_estim, cb_search, cb_progress,
+          0, 1.0));
+
+  GridAstar<2, 2> as(size);
+  as.setSearchTaskNum(0);
+  for (int i = 0; i < 100; ++i)
+  {
+    std::vector<Vec> path;
+    ASSERT_TRUE(
+        as.search(
+            Vec(2, 2), Vec(30, 2), path,
+            cb_cost, cb_cost_estim, cb_search, cb_progress,
+            0, 1.0));
+    ASSERT_EQ(path.front(), Vec(2, 2));
+    ASSERT_EQ(path.back(), Vec(30, 2));
+    for (const Vec& p : path)
+    {
+      ASSERT_FALSE(p[0] == 16 && p[1] < 28);
+    }
+    EXPECT_NEAR(path_cost(path_ref), path_cost(path), 1e-3);
+  }
+}
+
+TEST(GridAstar, ExpandedNodeNum)
+{
+  using Vec = CyclicVecInt<2, 2>;
+  const Vec size(32, 32);
+  omp_set_num_threads(1);
+
+  const auto cb_cost = [](
+      const Vec& s, const Vec& e, const Vec&, const Vec&) -> float
+  {
+    return (e - s).len();
+  };
+  const auto cb_cost_estim = [](const Vec& s, const Vec& e) -> float
+  {
+    return (e - s).len();
+  };
+  const auto cb_cost_estim_weak = [](const Vec& s, const Vec& e) -> float
+  {
+    return (e - s).len() * 0.1f;
+  };
+  std::vector<Vec> search;
+  for (int x = -1; x <= 1; ++x)
+  {
+    for (int y = -1; y <= 1; ++y)
+    {
+      if (x == 0 && y == 0)
+        continue;
+      search.push_back(Vec(x, y));
+    }
+  }
+  const auto cb_search = [&search](
+      const Vec&, const Vec&, const Vec&) -> std::vector<Vec>&
+  {
+    return search;
+  };
+  const auto cb_progress = [](const std::vector<Vec>&)
+  {
+    return true;
+  };
+
+  GridAstar<2, 2> as(size);
+  std::vector<Vec> path;
+  ASSERT_TRUE(
+      as.search(
+          Vec(2, 2), Vec(12, 2), path,
+          cb_cost, cb_cost_estim, cb_search, cb_progress,
+          0, 1.0));
+  const size_t expanded = as.getExpandedNodeNum();
+  ASSERT_EQ(expanded, 10u);
+
+  // Less informed heuristic expands more nodes
+  path.clear();
+  ASSERT_TRUE(
+      as.search(
+          Vec(2, 2), Vec(12, 2), path,
+          cb_cost, cb_cost_estim_weak, cb_search, cb_progress,
+          0, 1.0));
+  ASSERT_GT(as.getExpandedNodeNum(), expanded * 5);
+}
+
+TEST(GridAstar, Cancel)
+{
+  using Vec = CyclicVecInt<2, 2>;
+  const Vec size(32, 32);
+
+  std::vector<Vec> search;
+  for (int x = -1; x <= 1; ++x)
+  {
+    for (int y = -1; y <= 1; ++y)
+    {
+      if (x == 0 && y == 0)
+        continue;
+      search.push_back(Vec(x, y));
+    }
+  }
+  const auto cb_cost_estim = [](const Vec& s, const Vec& e) -> float
+  {
+    return (e - s).len() * 0.1f;
+  };
+  const auto cb_search = [&search](
+      const Vec&, const Vec&, const Vec&) -> std::vector<Vec>&
+  {
+    return search;
+  };
+  const auto cb_progress = [](const std::vector<Vec>&)
+  {
+    return true;
+  };
+
+  for (const int task_num : {1, 0})
+  {
+    GridAstar<2, 2> as(size);
+    as.setSearchTaskNum(task_num);
+    std::atomic<int> cnt(0);
+    const auto cb_cost = [&as, &cnt](
+        const Vec& s, const Vec& e, const Vec&, const Vec&) -> float
+    {
+      // Cancel from the outside of the search in the practical use.
+      if (++cnt == 100)
+        as.cancel();
+      return (e - s).len();
+    };
+
+    std::vector<Vec> path;
+    ASSERT_FALSE(
+        as.search(
+            Vec(2, 2), Vec(28, 28), path,
+            cb_cost, cb_cost_estim, cb_search, cb_progress,
+            0, 1.0, true));
+    ASSERT_TRUE(as.isCanceled());
+    ASSERT_EQ(0u, path.size());
+    ASSERT_LT(as.getExpandedNodeNum(), 100u);
+
+    // Searches are canceled until reset.
+    ASSERT_FALSE(
+        as.search(
+            Vec(2, 2), Vec(28, 28), path,
+            cb_cost, cb_cost_estim, cb_search, cb_progress,
+            0, 1.0, true));
+    as.resetCancel();
+    ASSERT_TRUE(
+        as.search(
+            Vec(2, 2), Vec(28, 28), path,
+            cb_cost, cb_cost_estim, cb_search, cb_progress,
+            0, 1.0, true));
+  }
+}
+
+TEST(GridAstar, QueueTypes)
+{
+  using Vec = CyclicVecInt<2, 2>;
+  const Vec size(32, 32);
+
+  const auto cb_cost = [](
+      const Vec& s, const Vec& e, const Vec&, const Vec&) -> float
+  {
+    if (e[0] == 16 && e[1] > 4)
+      return -1;
+    return (e - s).len();
+  };
+  const auto cb_cost_estim = [](const Vec& s, const Vec& e) -> float
+  {
+    return (e - s).len();
+  };
+  std::vector<Vec> search;
+  for (int x = -1; x <= 1; ++x)
+  {
+    for (int y = -1; y <= 1; ++y)
+    {
+      if (x != 0 || y != 0)
+        search.push_back(Vec(x, y));
+    }
+  }
+  const auto cb_search = [&search](
+      const Vec&, const Vec&, const Vec&) -> std::vector<Vec>&
+  {
+    return search;
+  };
+  const auto cb_progress = [](const std::vector<Vec>&)
+  {
+    return true;
+  };
+
+  const PriorityQueueType types[] =
+      {
+        PriorityQueueType::BINARY_HEAP,
+        PriorityQueueType::MIN_MAX_HEAP,
+        PriorityQueueType::RADIX_HEAP,
+      };
+  std::vector<size_t> path_sizes;
+  for (const PriorityQueueType type : types)
+  {
+    GridAstar<2, 2> as(size);
+    as.setSearchTaskNum(1);
+    as.setQueueType(type);
+    std::vector<Vec> path;
+    ASSERT_TRUE(
+        as.search(
+            Vec(8, 28), Vec(24, 28), path,
+            cb_cost, cb_cost_estim, cb_search, cb_progress,
+            0, 1.0));
+    path_sizes.push_back(path.size());
+  }
+  ASSERT_EQ(path_sizes[0], path_sizes[1]);
+  ASSERT_EQ(path_sizes[0], path_sizes[2]);
+
+  // Bounded queue must keep the most promising nodes.
+  const PriorityQueueType bounded_types[] =
+      {
+        PriorityQueueType::MIN_MAX_HEAP,
+        PriorityQueueType::RADIX_HEAP,
+      };
+  for (const PriorityQueueType type : bounded_types)
+  {
+    GridAstar<2, 2> as(size);
+    as.setSearchTaskNum(1);
+    as.setQueueType(type);
+    as.setQueueSizeLimit(64);
+    std::vector<Vec> path;
+    ASSERT_TRUE(
+        as.search(
+            Vec(8, 28), Vec(24, 28), path,
+            cb_cost, cb_cost_estim, cb_search, cb_progress,
+            0, 1.0));
+    ASSERT_EQ(path_sizes[0], path.size());
+  }
+}
+
+void testIncrementalSearch(const PriorityQueueType type)
+{
+  using Vec = CyclicVecInt<2, 2>;
+  const int w = 48;
+  const Vec size(w, w);
+  std::vector<char> map(w * w, 0);
+
+  int num_cost_calls = 0;
+  const auto cb_cost = [&map, &num_cost_calls](
+      const Vec& s, const Vec& e, const Vec&, const Vec&) -> float
+  {
+    ++num_cost_calls;
+    if (map[e[1] * w + e[0]])
+      return -1;
+    return (e - s).len();
+  };
+  const auto cb_cost_estim = [](const Vec& s, const Vec& e) -> float
+  {
+    return (e - s).len();
+  };
+  std::vector<Vec> search;
+  for (int x = -1; x <= 1; ++x)
+  {
+    for (int y = -1; y <= 1; ++y)
+    {
+      if (x != 0 || y != 0)
+        search.push_back(Vec(x, y));
+    }
+  }
+  const auto cb_search = [&search](
+      const Vec&, const Vec&, const Vec&) -> std::vector<Vec>&
+  {
+    return search;
+  };
+  const auto cb_progress = [](const std::vector<Vec>&)
+  {
+    return true;
+  };
+  const auto path_cost = [](const std::vector<Vec>& path)
+  {
+    float cost = 0;
+    for (auto it = std::next(path.begin()); it != path.end(); ++it)
+      cost += (*it - *std::prev(it)).len();
+    return cost;
+  };
+
+  GridAstar<2, 2> as(size);
+  as.setIncremental(true);
+  as.setQueueType(type);
+  GridAstar<2, 2> as_ref(size);
+
+  std::srand(0);
+  const Vec s(2, 2);
+  Vec e(w - 3, w - 3);
+  for (int i = 0; i < 200; ++i)
+  {
+    if (i % 20 == 10)
+    {
+      e = Vec(std::rand() % w, std::rand() % w);
+      map[e[1] * w + e[0]] = 0;
+    }
+    else if (i % 2 == 1)
+    {
+      // Toggle a random block
+      const Vec p(std::rand() % (w - 4), std::rand() % (w - 4));
+      const char v = std::rand() % 2;
+      for (int x = p[0]; x < p[0] + 4; ++x)
+      {
+        for (int y = p[1]; y < p[1] + 4; ++y)
+        {
+          if (Vec(x, y) != s && Vec(x, y) != e)
+            map[y * w + x] = v;
+        }
+      }
+      as.invalidate(p - Vec(1, 1), p + Vec(5, 5));
+    }
+
+    std::vector<Vec> path, path_ref;
+    num_cost_calls = 0;
+    const bool found = as.search(
+        s, e, path, cb_cost, cb_cost_estim, cb_search, cb_progress, 0, 1.0);
+    const int num_cost_calls_incremental = num_cost_calls;
+    num_cost_calls = 0;
+    const bool found_ref = as_ref.search(
+        s, e, path_ref, cb_cost, cb_cost_estim, cb_search, cb_progress, 0, 1.0);
+    const int num_cost_calls_ref = num_cost_calls;
+    ASSERT_EQ(found_ref, found);
+    if (!found)
+      continue;
+
+    ASSERT_EQ(s, path.front());
+    ASSERT_EQ(e, path.back());
+    for (const Vec& p : path)
+    {
+      ASSERT_FALSE(map[p[1] * w + p[0]]);
+    }
+    ASSERT_NEAR(path_cost(path_ref), path_cost(path), 1e-3);
+
+    if (i > 0 && i % 2 == 0 && i % 20 != 10)
+    {
+      // Nothing changed
+      ASSERT_LT(num_cost_calls_incremental, num_cost_calls_ref / 10);
+    }
+  }
+}
+
+TEST(GridAstar, IncrementalSearch)
+{
+  testIncrementalSearch(PriorityQueueType::BINARY_HEAP);
+}
+
+TEST(GridAstar, IncrementalSearchRadixHeap)
+{
+  // Repair of the search tree decreases the keys of the opened nodes.
+  testIncrementalSearch(PriorityQueueType::RADIX_HEAP);
+}
+
+void testAnytimeSearch(const PriorityQueueType type)
+{
+  using Vec = CyclicVecInt<2, 2>;
+  const int w = 64;
+  const Vec size(w, w);
+  omp_set_num_threads(1);
+
+  // Walls with gaps at the alternate ends
+  const auto occupied = [](const Vec& p)
+  {
+    if (p[0] % 8 != 4)
+      return false;
+    return (p[0] % 16 == 4) ? (p[1] < w - 4) : (p[1] >= 4);
+  };
+  const auto cb_cost = [&occupied](
+      const Vec& s, const Vec& e, const Vec&, const Vec&) -> float
+  {
+    if (occupied(e))
+      return -1;
+    return (e - s).len();
+  };
+  const auto cb_cost_estim = [](const Vec& s, const Vec& e) -> float
+  {
+    return (e - s).len();
+  };
+  std::vector<Vec> search;
+  for (int x = -1; x <= 1; ++x)
+  {
+    for (int y = -1; y <= 1; ++y)
+    {
+      if (x != 0 || y != 0)
+        search.push_back(Vec(x, y));
+    }
+  }
+  const auto cb_search = [&search](
+      const Vec&, const Vec&, const Vec&) -> std::vector<Vec>&
+  {
+    return search;
+  };
+  const auto cb_progress = [](const std::vector<Vec>&)
+  {
+    return true;
+  };
+  const auto path_cost = [](const std::vector<Vec>& path)
+  {
+    float cost = 0;
+    for (auto it = std::next(path.begin()); it != path.end(); ++it)
+      cost += (*it - *std::prev(it)).len();
+    return cost;
+  };
+  const Vec s(1, 32);
+  const Vec e(w - 2, 32);
+
+  GridAstar<2, 2> as_ref(size);
+  std::vector<Vec> path_ref;
+  ASSERT_TRUE(
+      as_ref.search(
+          s, e, path_ref,
+          cb_cost, cb_cost_estim, cb_search, cb_progress,
+          0, 1.0));
+  const float cost_opt = path_cost(path_ref);
+
+  GridAstar<2, 2> as(size);
+  as.setQueueType(type);
+
+  // Deadline passes just after the first path is found.
+  as.setAnytime(3.0, 0.5, 0.0);
+  std::vector<Vec> path_first;
+  ASSERT_TRUE(
+      as.search(
+          s, e, path_first,
+          cb_cost, cb_cost_estim, cb_search, cb_progress,
+          0, 1.0));
+  ASSERT_EQ(s, path_first.front());
+  ASSERT_EQ(e, path_first.back());
+  ASSERT_EQ(3.0, as.getSuboptimalityBound());
+  ASSERT_LE(path_cost(path_first), cost_opt * as.getSuboptimalityBound() + 1e-3);
+
+  // Enough time to reach the optimal path.
+  as.setAnytime(3.0, 0.5, 10.0);
+  std::vector<Vec> path;
+  ASSERT_TRUE(
+      as.search(
+          s, e, path,
+          cb_cost, cb_cost_estim, cb_search, cb_progress,
+          0, 1.0));
+  ASSERT_EQ(s, path.front());
+  ASSERT_EQ(e, path.back());
+  ASSERT_EQ(1.0, as.getSuboptimalityBound());
+  ASSERT_NEAR(cost_opt, path_cost(path), 1e-3);
+}
+
+TEST(GridAstar, AnytimeSearch)
+{
+  testAnytimeSearch(PriorityQueueType::BINARY_HEAP);
+}
+
+TEST(GridAstar, AnytimeSearchRadixHeap)
+{
+  // Decreasing the heuristic weight decreases the keys of the opened nodes.
+  testAnytimeSearch(PriorityQueueType::RADIX_HEAP);
+}
+
 TEST(GridAstar, SearchWithMultipleStarts)
 {
   using Vec = CyclicVecInt<1, 1>;
@@ -130,7 +633,7 @@ TEST(GridAstar, SearchWithMultipleStarts)
   {
     return search[p[0]];
   };
-  const auto cb_progress = [](const std::list<Vec>&)
+  const auto cb_progress = [](const std::vector<Vec>&)
   {
     return true;
   };
@@ -142,7 +645,7 @@ TEST(GridAstar, SearchWithMultipleStarts)
     starts.emplace_back(Vec(1));
     starts[add_cost_to].c_ = 0.1;
 
-    std::list<Vec> path;
+    std::vector<Vec> path;
     ASSERT_TRUE(
         as.search(
             starts, Vec(15), path,
@@ -164,11 +667,11 @@ public:
     : GridAstar(size)
   {
   }
-  std::unordered_map<Vec, Vec, Vec>& parentMap()
+  void setParent(const Vec& child, const Vec& parent)
   {
-    return parents_;
+    parents_[child] = parents_.address(parent);
   }
-  bool findPath(const Vec& s, const Vec& e, std::list<Vec>& path) const
+  bool findPath(const Vec& s, const Vec& e, std::vector<Vec>& path) const
   {
     return GridAstar::findPath(s, e, path);
   }
@@ -179,11 +682,11 @@ TEST(GridAstar, FindPathLooped)
   using Vec = GridAstarTestWrapper::Vec;
   GridAstarTestWrapper as(Vec(4));
 
-  as.parentMap()[Vec(3)] = Vec(2);
-  as.parentMap()[Vec(2)] = Vec(1);
-  as.parentMap()[Vec(1)] = Vec(2);
+  as.setParent(Vec(3), Vec(2));
+  as.setParent(Vec(2), Vec(1));
+  as.setParent(Vec(1), Vec(2));
 
-  std::list<Vec> path;
+  std::vector<Vec> path;
   const auto timeout_func = []()
   {
     try
@@ -207,9 +710,9 @@ TEST(GridAstar, FindPathUnconnected)
   using Vec = GridAstarTestWrapper::Vec;
   GridAstarTestWrapper as(Vec(3));
 
-  as.parentMap()[Vec(2)] = Vec(1);
+  as.setParent(Vec(2), Vec(1));
 
-  std::list<Vec> path;
+  std::vector<Vec> path;
   ASSERT_FALSE(as.findPath(Vec(0), Vec(2), path));
 }
 
@@ -218,13 +721,13 @@ TEST(GridAstar, FindPath)
   using Vec = GridAstarTestWrapper::Vec;
   GridAstarTestWrapper as(Vec(3));
 
-  as.parentMap()[Vec(2)] = Vec(1);
-  as.parentMap()[Vec(1)] = Vec(0);
+  as.setParent(Vec(2), Vec(1));
+  as.setParent(Vec(1), Vec(0));
 
   // findPath must return same result for multiple calls
   for (int i = 0; i < 2; ++i)
   {
-    std::list<Vec> path;
+    std::vector<Vec> path;
     ASSERT_TRUE(as.findPath(Vec(0), Vec(2), path));
     ASSERT_EQ(path.size(), 3u);
     auto it = path.cbegin();
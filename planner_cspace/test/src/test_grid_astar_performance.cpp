@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/chrono.hpp>
+
+#include <omp.h>
+
+#include <gtest/gtest.h>
+
+#include <planner_cspace/grid_astar.h>
+
+class GridAstarPerformanceWrapper : public GridAstar<3, 2>
+{
+public:
+  explicit GridAstarPerformanceWrapper(const Vec& size)
+    : GridAstar(size)
+  {
+  }
+  void setParent(const Vec& child, const Vec& parent)
+  {
+    parents_[child] = parents_.address(parent);
+  }
+  bool findPath(const Vec& s, const Vec& e, std::vector<Vec>& path) const
+  {
+    return GridAstar::findPath(s, e, path);
+  }
+  void clearParents()
+  {
+    parents_.clear(PARENT_NONE);
+  }
+};
+
+namespace
+{
+// Path reconstruction using hashed parent map; used by GridAstar before
+// the dense parent map was introduced.
+bool findPathHashed(
+    const std::unordered_map<GridAstar<3, 2>::Vec, GridAstar<3, 2>::Vec, GridAstar<3, 2>::Vec>& parents_src,
+    const GridAstar<3, 2>::Vec& s, const GridAstar<3, 2>::Vec& e,
+    std::vector<GridAstar<3, 2>::Vec>& path)
+{
+  using Vec = GridAstar<3, 2>::Vec;
+  std::unordered_map<Vec, Vec, Vec> parents = parents_src;
+  Vec n = e;
+  while (true)
+  {
+    path.push_back(n);
+    if (n == s)
+      break;
+    if (parents.find(n) == parents.end())
+      return false;
+
+    const Vec child = n;
+    n = parents[child];
+    parents.erase(child);
+  }
+  std::reverse(path.begin(), path.end());
+  return true;
+}
+}  // namespace
+
+TEST(GridAstarPerformance, FindPath)
+{
+  using Vec = GridAstarPerformanceWrapper::Vec;
+  const Vec size(0x100, 0x100, 0x10);
+  const int repeat = 10;
+
+  GridAstarPerformanceWrapper as(size);
+  std::unordered_map<Vec, Vec, Vec> parents_hashed;
+  parents_hashed.reserve(size[0] * size[1] * size[2]);
+
+  // All grids are connected to the start (0, 0, 0) through
+  // the parent on -x side or -y side like a finished search.
+  Vec p;
+  for (p[2] = 0; p[2] < size[2]; ++p[2])
+  {
+    for (p[1] = 0; p[1] < size[1]; ++p[1])
+    {
+      for (p[0] = 0; p[0] < size[0]; ++p[0])
+      {
+        Vec parent = p;
+        if (p[0] > 0)
+          parent[0]--;
+        else if (p[1] > 0)
+          parent[1]--;
+        else if (p[2] > 0)
+          parent[2]--;
+        else
+          continue;
+        as.setParent(p, parent);
+        parents_hashed[p] = parent;
+      }
+    }
+  }
+
+  const Vec s(0, 0, 0);
+  const Vec e(size[0] - 1, size[1] - 1, size[2] - 1);
+  const size_t path_size = size[0] + size[1] + size[2] - 2;
+
+  boost::chrono::duration<float> d_hashed(0);
+  boost::chrono::duration<float> d_dense(0);
+  for (int i = 0; i < repeat; ++i)
+  {
+    std::vector<Vec> path_hashed;
+    const auto ts0 = boost::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(findPathHashed(parents_hashed, s, e, path_hashed));
+    const auto te0 = boost::chrono::high_resolution_clock::now();
+    d_hashed += te0 - ts0;
+
+    std::vector<Vec> path_dense;
+    const auto ts1 = boost::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(as.findPath(s, e, path_dense));
+    const auto te1 = boost::chrono::high_resolution_clock::now();
+    d_dense += te1 - ts1;
+
+    ASSERT_EQ(path_size, path_hashed.size());
+    ASSERT_EQ(path_hashed, path_dense);
+  }
+  std::cout << "findPath (hashed parents): " << d_hashed.count() / repeat << " sec" << std::endl;
+  std::cout << "findPath (dense parents): " << d_dense.count() / repeat << " sec" << std::endl;
+  std::cout << "Improvement ratio: " << d_hashed.count() / d_dense.count() << std::endl;
+  ASSERT_LT(d_dense, d_hashed);
+}
+
+TEST(GridAstarPerformance, SearchCallbackDispatch)
+{
+  using Vec = GridAstar<3, 2>::Vec;
+  const Vec size(0x80, 0x80, 0x4);
+  const int repeat = 5;
+  omp_set_num_threads(1);
+
+  std::vector<Vec> search_list;
+  Vec d;
+  for (d[0] = -2; d[0] <= 2; ++d[0])
+  {
+    for (d[1] = -2; d[1] <= 2; ++d[1])
+    {
+      for (d[2] = -1; d[2] <= 1; ++d[2])
+      {
+        if (d[0] != 0 || d[1] != 0 || d[2] != 0)
+          search_list.push_back(d);
+      }
+    }
+  }
+  size_t num_expanded = 0;
+  const auto cb_cost = [](const Vec& s, const Vec& e, const Vec&, const Vec&) -> float
+  {
+    const Vec d = e - s;
+    return d.len() + std::abs(d[2]) * 0.5f;
+  };
+  // Dijkstra search to expand all nodes
+  const auto cb_cost_estim = [](const Vec& /* s */, const Vec& /* e */) -> float
+  {
+    return 0;
+  };
+  const auto cb_search = [&search_list, &num_expanded](
+      const Vec&, const Vec&, const Vec&) -> std::vector<Vec>&
+  {
+    ++num_expanded;
+    return search_list;
+  };
+  const auto cb_progress = [](const std::vector<Vec>&)
+  {
+    return true;
+  };
+
+  const GridAstar<3, 2>::CostFunctionSingleStart cb_cost_func = cb_cost;
+  const GridAstar<3, 2>::CostEstimFunction cb_cost_estim_func = cb_cost_estim;
+  const GridAstar<3, 2>::SearchNextFunctionSingleStart cb_search_func = cb_search;
+  const GridAstar<3, 2>::ProgressFunction cb_progress_func = cb_progress;
+
+  GridAstar<3, 2> as(size);
+  as.setSearchTaskNum(64);
+  const Vec s(0, 0, 0);
+  const Vec e(size[0] - 1, size[1] - 1, 0);
+  const float cost_leave = -1;
+
+  boost::chrono::duration<float> d_function(FLT_MAX);
+  boost::chrono::duration<float> d_template(FLT_MAX);
+  size_t num_expanded_function = 0;
+  size_t num_expanded_template = 0;
+  for (int i = 0; i < repeat; ++i)
+  {
+    std::vector<Vec> path_function;
+    num_expanded = 0;
+    const auto ts0 = boost::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(as.search(
+        s, e, path_function,
+        cb_cost_func, cb_cost_estim_func, cb_search_func, cb_progress_func,
+        cost_leave, 10.0));
+    const auto te0 = boost::chrono::high_resolution_clock::now();
+    d_function = std::min<boost::chrono::duration<float>>(d_function, te0 - ts0);
+    num_expanded_function = num_expanded;
+
+    std::vector<Vec> path_template;
+    num_expanded = 0;
+    const auto ts1 = boost::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(as.search(
+        s, e, path_template,
+        cb_cost, cb_cost_estim, cb_search, cb_progress,
+        cost_leave, 10.0));
+    const auto te1 = boost::chrono::high_resolution_clock::now();
+    d_template = std::min<boost::chrono::duration<float>>(d_template, te1 - ts1);
+    num_expanded_template = num_expanded;
+
+    ASSERT_EQ(path_function, path_template);
+  }
+  ASSERT_EQ(num_expanded_function, num_expanded_template);
+  std::cout << "Expanded nodes: " << num_expanded_template << std::endl;
+  std::cout << "search (std::function): "
+            << d_function.count() * 1e9 / num_expanded_function << " nsec/expansion" << std::endl;
+  std::cout << "search (template): "
+            << d_template.count() * 1e9 / num_expanded_template << " nsec/expansion" << std::endl;
+  std::cout << "Improvement ratio: " << d_function.count() / d_template.count() << std::endl;
+  ASSERT_LT(d_template, d_function);
+}
+
+TEST(GridAstarPerformance, SearchOnLargeMap)
+{
+  using Vec = GridAstarPerformanceWrapper::Vec;
+  const Vec size(0x400, 0x400, 0x10);
+  const int repeat = 10;
+  omp_set_num_threads(1);
+
+  std::vector<Vec> search_list;
+  Vec d(0, 0, 0);
+  for (d[0] = -1; d[0] <= 1; ++d[0])
+  {
+    for (d[1] = -1; d[1] <= 1; ++d[1])
+    {
+      if (d[0] != 0 || d[1] != 0)
+        search_list.push_back(d);
+    }
+  }
+  const auto cb_cost = [](const Vec& s, const Vec& e, const Vec&, const Vec&) -> float
+  {
+    return (e - s).len();
+  };
+  const auto cb_cost_estim = [](const Vec& s, const Vec& e) -> float
+  {
+    return (e - s).len();
+  };
+  const auto cb_search = [&search_list](const Vec&, const Vec&, const Vec&) -> std::vector<Vec>&
+  {
+    return search_list;
+  };
+  const auto cb_progress = [](const std::vector<Vec>&)
+  {
+    return true;
+  };
+
+  // Short searches on the large map like the replannings along the path.
+  GridAstarPerformanceWrapper as(size);
+  const Vec s(0x100, 0x100, 0);
+  const Vec e(0x110, 0x108, 0);
+
+  boost::chrono::duration<float> d_clear(0);
+  boost::chrono::duration<float> d_epoch(0);
+  for (int i = 0; i < repeat; ++i)
+  {
+    // Search clearing the parents of all grids as before.
+    std::vector<Vec> path_clear;
+    const auto ts0 = boost::chrono::high_resolution_clock::now();
+    as.clearParents();
+    ASSERT_TRUE(as.search(
+        s, e, path_clear,
+        cb_cost, cb_cost_estim, cb_search, cb_progress,
+        0, 10.0));
+    const auto te0 = boost::chrono::high_resolution_clock::now();
+    d_clear += te0 - ts0;
+
+    std::vector<Vec> path_epoch;
+    const auto ts1 = boost::chrono::high_resolution_clock::now();
+    ASSERT_TRUE(as.search(
+        s, e, path_epoch,
+        cb_cost, cb_cost_estim, cb_search, cb_progress,
+        0, 10.0));
+    const auto te1 = boost::chrono::high_resolution_clock::now();
+    d_epoch += te1 - ts1;
+
+    ASSERT_EQ(path_clear, path_epoch);
+  }
+  std::cout << "search (clearing parents): " << d_clear.count() / repeat << " sec" << std::endl;
+  std::cout << "search: " << d_epoch.count() / repeat << " sec" << std::endl;
+  std::cout << "Improvement ratio: " << d_clear.count() / d_epoch.count() << std::endl;
+  ASSERT_LT(d_epoch, d_clear);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
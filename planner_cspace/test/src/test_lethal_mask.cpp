@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdlib>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <planner_cspace/blockmem_gridmap.h>
+#include <planner_cspace/planner_3d/lethal_mask.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+TEST(LethalMask, Collides)
+{
+  using Vec = LethalMask::Vec;
+  const Vec size(150, 40, 4);
+  BlockMemGridmap<char, 3, 2, 0x40> cm(size);
+  srand(1);
+  for (Vec p(0, 0, 0); p[2] < size[2]; p[2]++)
+  {
+    for (p[1] = 0; p[1] < size[1]; p[1]++)
+    {
+      for (p[0] = 0; p[0] < size[0]; p[0]++)
+      {
+        cm[p] = (rand() % 40 == 0) ? 100 : rand() % 100;
+      }
+    }
+  }
+  LethalMask mask;
+  mask.reset(size);
+  mask.update(cm, Vec(0, 0, 0), size);
+
+  const auto collides_ref = [&cm](const Vec& s, const std::vector<Vec>& cells)
+  {
+    for (const Vec& c : cells)
+    {
+      if (cm[Vec(s[0] + c[0], s[1] + c[1], c[2])] > 99)
+        return true;
+    }
+    return false;
+  };
+  const auto check = [&]()
+  {
+    for (int i = 0; i < 2000; ++i)
+    {
+      // Straight lines up to 80 cells long and scattered cells
+      std::vector<Vec> cells;
+      const int len = rand() % 80 + 1;
+      const int dy = rand() % 5 - 2;
+      const int yaw = rand() % size[2];
+      for (int x = -len / 2; x < len - len / 2; ++x)
+        cells.emplace_back(x, dy, yaw);
+      for (int j = 0; j < 5; ++j)
+        cells.emplace_back(rand() % 9 - 4, rand() % 9 - 4, rand() % size[2]);
+      const Vec s(rand() % (size[0] - 90) + 45, rand() % (size[1] - 10) + 5, 0);
+
+      const LethalMask::Footprint footprint = LethalMask::createFootprint(cells);
+      ASSERT_EQ(collides_ref(s, cells), mask.collides(s, footprint));
+    }
+  };
+  check();
+
+  // Update the area
+  for (Vec p(60, 10, 0); p[2] < size[2]; p[2]++)
+  {
+    for (p[1] = 10; p[1] < 20; p[1]++)
+    {
+      for (p[0] = 60; p[0] < 130; p[0]++)
+      {
+        cm[p] = (cm[p] > 99) ? 0 : ((rand() % 10 == 0) ? 100 : 0);
+      }
+    }
+  }
+  mask.update(cm, Vec(60, 10, 0), Vec(130, 20, 0));
+  for (Vec p(0, 0, 0); p[2] < size[2]; p[2]++)
+  {
+    for (p[1] = 0; p[1] < size[1]; p[1]++)
+    {
+      for (p[0] = 0; p[0] < size[0]; p[0]++)
+      {
+        ASSERT_EQ(cm[p] > 99, mask.get(p));
+      }
+    }
+  }
+  check();
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
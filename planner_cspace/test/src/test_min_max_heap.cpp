@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <planner_cspace/min_max_heap.h>
+
+TEST(MinMaxHeap, PopBothEnds)
+{
+  std::srand(0);
+  for (int n = 1; n < 200; n += 7)
+  {
+    min_max_heap<int> heap;
+    std::vector<int> ref;
+    for (int i = 0; i < n; ++i)
+    {
+      const int v = std::rand() % 100;
+      heap.push(v);
+      ref.push_back(v);
+    }
+    std::sort(ref.begin(), ref.end());
+
+    bool front = false;
+    while (!ref.empty())
+    {
+      ASSERT_EQ(ref.size(), heap.size());
+      ASSERT_EQ(ref.back(), heap.top());
+      ASSERT_EQ(ref.front(), heap.bottom());
+      if (front)
+      {
+        heap.pop();
+        ref.pop_back();
+      }
+      else
+      {
+        heap.pop_back();
+        ref.erase(ref.begin());
+      }
+      front = !front;
+    }
+    ASSERT_TRUE(heap.empty());
+  }
+}
+
+TEST(MinMaxHeap, SizeLimit)
+{
+  // Keeping the queue size by pop_back() must keep the highest elements.
+  std::srand(1);
+  const size_t limit = 16;
+  min_max_heap<int> heap;
+  std::vector<int> ref;
+  for (int i = 0; i < 1000; ++i)
+  {
+    const int v = std::rand();
+    heap.push(v);
+    ref.push_back(v);
+    if (heap.size() > limit)
+      heap.pop_back();
+  }
+  std::sort(ref.begin(), ref.end(), std::greater<int>());
+  for (size_t i = 0; i < limit; ++i)
+  {
+    ASSERT_EQ(ref[i], heap.top());
+    heap.pop();
+  }
+  ASSERT_TRUE(heap.empty());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -27,7 +27,15 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <unistd.h>
+
 #include <cstddef>
+#include <iostream>
+#include <string>
+
+#include <boost/chrono.hpp>
+
+#include <omp.h>
 
 #include <gtest/gtest.h>
 
@@ -125,6 +133,186 @@ TEST(MotionCache, Generate)
   }
 }
 
+TEST(MotionCache, SaveLoad)
+{
+  const int range = 4;
+  const int angle = 8;
+  const float angular_resolution = M_PI * 2 / angle;
+  const float linear_resolution = 0.5;
+
+  BlockMemGridmap<char, 3, 2, 0x20> gm;
+  gm.reset(CyclicVecInt<3, 2>(32, 32, angle));
+  MotionCache cache;
+  cache.reset(
+      linear_resolution, angular_resolution, range,
+      gm.getAddressor());
+
+  const std::string file_name = "/tmp/test_motion_cache_" + std::to_string(getpid()) + ".bin";
+  ASSERT_TRUE(cache.save(file_name));
+
+  MotionCache loaded;
+  ASSERT_TRUE(loaded.load(file_name, linear_resolution, angular_resolution, range, gm.getAddressor()));
+  ASSERT_EQ(cache.getMaxRange(), loaded.getMaxRange());
+
+  CyclicVecInt<3, 2> d;
+  for (int syaw = 0; syaw < angle; ++syaw)
+  {
+    for (d[0] = -range - 1; d[0] <= range + 1; d[0]++)
+    {
+      for (d[1] = -range - 1; d[1] <= range + 1; d[1]++)
+      {
+        for (d[2] = 0; d[2] < angle; d[2]++)
+        {
+          const auto c = cache.find(syaw, d);
+          const auto l = loaded.find(syaw, d);
+          if (c == cache.end(syaw))
+          {
+            ASSERT_EQ(l, loaded.end(syaw));
+            continue;
+          }
+          ASSERT_NE(l, loaded.end(syaw));
+          ASSERT_EQ(c->first, l->first);
+          ASSERT_EQ(c->second.getDistance(), l->second.getDistance());
+          const auto cm = c->second.getMotion();
+          const auto lm = l->second.getMotion();
+          ASSERT_EQ(cm.size(), lm.size());
+          for (size_t i = 0; i < cm.size(); ++i)
+            ASSERT_EQ(cm[i], lm[i]);
+        }
+      }
+    }
+  }
+
+  // Parameters and the addressor must match.
+  MotionCache other;
+  ASSERT_FALSE(other.load(file_name, linear_resolution * 2, angular_resolution, range, gm.getAddressor()));
+  ASSERT_FALSE(other.load(file_name, linear_resolution, angular_resolution, range + 1, gm.getAddressor()));
+  BlockMemGridmap<char, 3, 2, 0x20> gm2;
+  gm2.reset(CyclicVecInt<3, 2>(64, 64, angle));
+  ASSERT_FALSE(other.load(file_name, linear_resolution, angular_resolution, range, gm2.getAddressor()));
+
+  // Broken file must be rejected.
+  FILE* fp = fopen(file_name.c_str(), "r+b");
+  ASSERT_NE(fp, nullptr);
+  fseek(fp, -4, SEEK_END);
+  const int32_t broken = 12345;
+  fwrite(&broken, sizeof(broken), 1, fp);
+  fclose(fp);
+  ASSERT_FALSE(other.load(file_name, linear_resolution, angular_resolution, range, gm.getAddressor()));
+
+  unlink(file_name.c_str());
+}
+
+TEST(MotionCache, RejectOtherMapSize)
+{
+  const int range = 4;
+  const int angle = 8;
+  const float angular_resolution = M_PI * 2 / angle;
+  const float linear_resolution = 0.5;
+
+  // Cache built for the previous map.
+  BlockMemGridmap<char, 3, 2, 0x20> gm_prev;
+  gm_prev.reset(CyclicVecInt<3, 2>(0x20, 0x20, angle));
+  MotionCache cache;
+  cache.reset(linear_resolution, angular_resolution, range, gm_prev.getAddressor());
+  const std::string file_name = "/tmp/test_motion_cache_size_" + std::to_string(getpid()) + ".bin";
+  ASSERT_TRUE(cache.save(file_name));
+
+  // Cache is accepted only by the map of the same size.
+  BlockMemGridmap<char, 3, 2, 0x20> gm;
+  gm.reset(CyclicVecInt<3, 2>(0x20, 0x20, angle));
+  MotionCache loaded;
+  ASSERT_TRUE(loaded.load(file_name, linear_resolution, angular_resolution, range, gm.getAddressor()));
+
+  gm.reset(CyclicVecInt<3, 2>(0x60, 0x40, angle));
+  ASSERT_FALSE(loaded.load(file_name, linear_resolution, angular_resolution, range, gm.getAddressor()));
+
+  unlink(file_name.c_str());
+}
+
+TEST(MotionCache, StartupPerformance)
+{
+  // 0.4 m range at 2.5 cm resolution with 32 angles
+  const int range = 16;
+  const int angle = 32;
+  const float angular_resolution = M_PI * 2 / angle;
+  const float linear_resolution = 0.025;
+
+  BlockMemGridmap<char, 3, 2, 0x40> gm;
+  gm.reset(CyclicVecInt<3, 2>(0x100, 0x100, angle));
+
+  // Sequential build
+  const int num_threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  MotionCache cache_seq;
+  const auto ts0 = boost::chrono::high_resolution_clock::now();
+  cache_seq.reset(
+      linear_resolution, angular_resolution, range,
+      gm.getAddressor());
+  const auto te0 = boost::chrono::high_resolution_clock::now();
+  omp_set_num_threads(num_threads);
+  const boost::chrono::duration<float> d_seq = te0 - ts0;
+
+  // Parallel build
+  MotionCache cache_par;
+  const auto ts1 = boost::chrono::high_resolution_clock::now();
+  cache_par.reset(
+      linear_resolution, angular_resolution, range,
+      gm.getAddressor());
+  const auto te1 = boost::chrono::high_resolution_clock::now();
+  const boost::chrono::duration<float> d_par = te1 - ts1;
+
+  // Load from the cache file
+  const std::string file_name = "/tmp/test_motion_cache_startup_" + std::to_string(getpid()) + ".bin";
+  ASSERT_TRUE(cache_seq.save(file_name));
+  MotionCache cache;
+  const auto ts2 = boost::chrono::high_resolution_clock::now();
+  ASSERT_TRUE(cache.load(file_name, linear_resolution, angular_resolution, range, gm.getAddressor()));
+  const auto te2 = boost::chrono::high_resolution_clock::now();
+  const boost::chrono::duration<float> d_load = te2 - ts2;
+  unlink(file_name.c_str());
+
+  std::cout << "MotionCache (range: " << range << ", angle: " << angle << ")" << std::endl;
+  std::cout << "  sequential build: " << d_seq.count() << " sec" << std::endl;
+  std::cout << "  parallel build (" << num_threads << " threads): " << d_par.count() << " sec" << std::endl;
+  std::cout << "  load: " << d_load.count() << " sec" << std::endl;
+  std::cout << "Improvement ratio (parallel build): " << d_seq.count() / d_par.count() << std::endl;
+  std::cout << "Improvement ratio (load): " << d_seq.count() / d_load.count() << std::endl;
+  ASSERT_LT(d_load, d_seq);
+
+  size_t num_pages = 0;
+  for (int syaw = 0; syaw < angle; ++syaw)
+  {
+    CyclicVecInt<3, 2> d;
+    for (d[0] = -range; d[0] <= range; d[0]++)
+    {
+      for (d[1] = -range; d[1] <= range; d[1]++)
+      {
+        for (d[2] = 0; d[2] < angle; d[2]++)
+        {
+          const auto c = cache.find(syaw, d);
+          if ((d[0] == 0 && d[1] == 0) || d.sqlen() > range * range)
+          {
+            ASSERT_EQ(c, cache.end(syaw));
+            continue;
+          }
+          ASSERT_NE(c, cache.end(syaw));
+          ++num_pages;
+
+          // Cells must be sorted by the address and must not be duplicated.
+          const auto motion = c->second.getMotion();
+          for (size_t i = 1; i < motion.size(); ++i)
+          {
+            ASSERT_NE(motion[i - 1], motion[i]);
+            ASSERT_LE(gm.address(motion[i - 1]), gm.address(motion[i]));
+          }
+        }
+      }
+    }
+  }
+  std::cout << "Number of pages: " << num_pages << std::endl;
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
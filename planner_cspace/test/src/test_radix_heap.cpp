@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <planner_cspace/radix_heap.h>
+
+namespace
+{
+class Identity
+{
+public:
+  float operator()(const float v) const
+  {
+    return v;
+  }
+};
+using Heap = radix_heap<float, Identity>;
+}  // namespace
+
+TEST(RadixHeap, Encode)
+{
+  const float values[] = { -1e10, -3.0, -0.5, 0.0, 1e-20, 0.5, 3.0, 1e10 };
+  for (size_t i = 1; i < sizeof(values) / sizeof(values[0]); ++i)
+  {
+    ASSERT_LT(Heap::encode(values[i - 1]),
+              Heap::encode(values[i]));
+  }
+}
+
+TEST(RadixHeap, Monotone)
+{
+  std::srand(0);
+  Heap heap;
+  std::vector<float> popped;
+  float last = -10.0;
+  heap.push(last);
+  for (int i = 0; i < 10000; ++i)
+  {
+    if (heap.empty() || std::rand() % 3 != 0)
+    {
+      heap.push(last + (std::rand() % 1000) * 0.01);
+      continue;
+    }
+    const float v = heap.top();
+    heap.pop();
+    ASSERT_GE(v, last);
+    last = v;
+  }
+  while (!heap.empty())
+  {
+    const float v = heap.top();
+    heap.pop();
+    ASSERT_GE(v, last);
+    last = v;
+  }
+}
+
+TEST(RadixHeap, PopBack)
+{
+  std::srand(1);
+  const size_t limit = 16;
+  Heap heap;
+  std::vector<float> ref;
+  for (int i = 0; i < 1000; ++i)
+  {
+    const float v = (std::rand() % 100000) * 0.1;
+    heap.push(v);
+    ref.push_back(v);
+    if (heap.size() > limit)
+      heap.pop_back();
+  }
+  std::sort(ref.begin(), ref.end());
+  for (size_t i = 0; i < limit; ++i)
+  {
+    ASSERT_EQ(ref[i], heap.top());
+    heap.pop();
+  }
+  ASSERT_TRUE(heap.empty());
+}
+
+TEST(RadixHeap, NonMonotone)
+{
+  // Keys smaller than the last popped one are treated as the last one.
+  Heap heap;
+  heap.push(1.0);
+  heap.push(3.0);
+  ASSERT_EQ(1.0, heap.top());
+  heap.pop();
+  heap.push(0.5);
+  heap.push(2.0);
+  ASSERT_EQ(0.5, heap.top());
+  heap.pop();
+  ASSERT_EQ(2.0, heap.top());
+  heap.pop();
+  ASSERT_EQ(3.0, heap.top());
+  heap.pop();
+  ASSERT_TRUE(heap.empty());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <planner_cspace/cyclic_vec.h>
+#include <planner_cspace/planner_3d/start_prediction.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+using Pose = CyclicVecFloat<3, 2>;
+
+Pose pose2d(const float x, const float y, const float yaw)
+{
+  return Pose(x, y, yaw);
+}
+
+TEST(StartPrediction, ZeroVelocity)
+{
+  const Pose pose = pose2d(1.0, 2.0, 0.5);
+  ASSERT_EQ(0.0f, estimateLinearVelocity(pose, pose, 0.1));
+  ASSERT_EQ(0.0f, estimateLinearVelocity(pose, pose2d(1.5, 2.0, 0.5), 0.0));
+
+  std::vector<Pose> path;
+  for (int i = 0; i < 20; ++i)
+    path.push_back(pose2d(i * 0.1, 0.0, 0.0));
+
+  // Stopped robot stays at the nearest pose.
+  size_t i_nearest, i_predicted;
+  ASSERT_TRUE(predictPoseOnPath(path, pose2d(0.51, 0.01, 0.0), 0.0, 0.1, i_nearest, i_predicted));
+  ASSERT_EQ(5u, i_nearest);
+  ASSERT_EQ(5u, i_predicted);
+}
+
+TEST(StartPrediction, ConstantVelocity)
+{
+  ASSERT_NEAR(0.5, estimateLinearVelocity(pose2d(0.0, 0.0, 0.0), pose2d(0.25, 0.0, 0.0), 0.5), 1e-4);
+
+  std::vector<Pose> path;
+  for (int i = 0; i < 20; ++i)
+    path.push_back(pose2d(i * 0.1, 0.0, 0.0));
+
+  size_t i_nearest, i_predicted;
+  const float latency = 0.6;
+  ASSERT_TRUE(predictPoseOnPath(path, pose2d(0.5, 0.02, 0.0), 0.5 * latency, 0.1, i_nearest, i_predicted));
+  ASSERT_EQ(5u, i_nearest);
+  ASSERT_EQ(8u, i_predicted);
+
+  // Robot is not following the path.
+  ASSERT_FALSE(predictPoseOnPath(path, pose2d(0.5, 0.2, 0.0), 0.3, 0.1, i_nearest, i_predicted));
+  // Path ends before the predicted pose.
+  ASSERT_FALSE(predictPoseOnPath(path, pose2d(1.5, 0.0, 0.0), 0.5, 0.1, i_nearest, i_predicted));
+}
+
+TEST(StartPrediction, TurningVelocity)
+{
+  // Robot moving along a circle of radius 1.0 at 0.5 m/s.
+  const float radius = 1.0;
+  const auto pose_on_circle = [radius](const float angle)
+  {
+    return pose2d(radius * std::sin(angle), radius * (1.0 - std::cos(angle)), angle);
+  };
+  const float vel = estimateLinearVelocity(pose_on_circle(0.0), pose_on_circle(0.5), 1.0);
+  ASSERT_NEAR(0.5, vel, 1e-4);
+  // Clockwise turn.
+  ASSERT_NEAR(
+      0.5,
+      estimateLinearVelocity(
+          pose2d(0.0, 0.0, 0.0), pose2d(std::sin(0.5), -(1.0 - std::cos(0.5)), -0.5), 1.0),
+      1e-4);
+
+  std::vector<Pose> path;
+  const float step = 0.05;
+  for (int i = 0; i < 60; ++i)
+    path.push_back(pose_on_circle(i * step));
+
+  // The robot travels 0.5 rad (10 poses) along the arc during the latency of 1.0 sec.
+  size_t i_nearest, i_predicted;
+  ASSERT_TRUE(predictPoseOnPath(path, pose_on_circle(0.5), vel * 1.0, 0.1, i_nearest, i_predicted));
+  ASSERT_EQ(10u, i_nearest);
+  ASSERT_NEAR(20, static_cast<int>(i_predicted), 1);
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2019, the neonavigation authors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include <omp.h>
+
+#include <gtest/gtest.h>
+
+#include <planner_cspace/blockmem_gridmap.h>
+#include <planner_cspace/grid_astar.h>
+#include <planner_cspace/planner_3d/yaw_heuristic_table.h>
+
+namespace planner_cspace
+{
+namespace planner_3d
+{
+namespace
+{
+// Robot on 4 yaws (+x, +y, -x, -y) moving forward by one cell or turning in place.
+constexpr int ANGLE = 4;
+constexpr float TURN_COST = 3.0f;
+
+bool isTurn(const YawHeuristicTable::Vec& d)
+{
+  return d[0] == 0 && d[1] == 0;
+}
+YawHeuristicTable::Vec forward(const int yaw)
+{
+  const int dx[ANGLE] = {1, 0, -1, 0};
+  const int dy[ANGLE] = {0, 1, 0, -1};
+  return YawHeuristicTable::Vec(dx[yaw], dy[yaw], 0);
+}
+}  // namespace
+
+TEST(YawHeuristicTable, Get)
+{
+  using Vec = YawHeuristicTable::Vec;
+  YawHeuristicTable table;
+  ASSERT_FALSE(table.enabled());
+
+  table.reset(ANGLE, 4, 1, 1.0f);
+  ASSERT_TRUE(table.enabled());
+  for (int yaw = 0; yaw < ANGLE; ++yaw)
+  {
+    const Vec f = forward(yaw);
+    table.addMotion(yaw, Vec(f[0], f[1], yaw), 1.0f);
+    table.addMotion(yaw, Vec(0, 0, (yaw + 1) % ANGLE), TURN_COST);
+    table.addMotion(yaw, Vec(0, 0, (yaw + ANGLE - 1) % ANGLE), TURN_COST);
+  }
+  ASSERT_FALSE(table.created(0));
+  ASSERT_EQ(0.0f, table.get(Vec(-2, 0, 0), 0));
+
+  table.create(0);
+  ASSERT_TRUE(table.created(0));
+  ASSERT_FALSE(table.created(2));
+  ASSERT_EQ(0.0f, table.get(Vec(0, 0, 0), 0));
+  // Straight to the goal.
+  ASSERT_EQ(2.0f, table.get(Vec(-2, 0, 0), 0));
+  // Turn at the start and at the goal.
+  ASSERT_EQ(2.0f + TURN_COST * 2, table.get(Vec(0, -2, 0), 0));
+  // Turn back at the goal.
+  ASSERT_EQ(2.0f + TURN_COST * 2, table.get(Vec(-2, 0, 2), 0));
+  // Outside of the table.
+  ASSERT_EQ(0.0f, table.get(Vec(-5, 0, 0), 0));
+  ASSERT_EQ(0.0f, table.get(Vec(-2, 0, 0), 2));
+}
+
+TEST(YawHeuristicTable, ExpandedNodeNum)
+{
+  using Vec = CyclicVecInt<3, 2>;
+  const Vec size(32, 32, ANGLE);
+  omp_set_num_threads(1);
+
+  // Wall between the start and the goal.
+  BlockMemGridmap<char, 3, 2> cm(size);
+  cm.clear(0);
+  for (int y = 8; y < 24; ++y)
+  {
+    for (int yaw = 0; yaw < ANGLE; ++yaw)
+      cm[Vec(16, y, yaw)] = 100;
+  }
+
+  std::vector<std::vector<Vec>> search_list(ANGLE);
+  YawHeuristicTable table;
+  table.reset(ANGLE, 16, 1, 1.0f);
+  for (int yaw = 0; yaw < ANGLE; ++yaw)
+  {
+    search_list[yaw].push_back(forward(yaw));
+    search_list[yaw].push_back(Vec(0, 0, 1));
+    search_list[yaw].push_back(Vec(0, 0, -1));
+
+    const Vec f = forward(yaw);
+    table.addMotion(yaw, Vec(f[0], f[1], yaw), 1.0f);
+    table.addMotion(yaw, Vec(0, 0, (yaw + 1) % ANGLE), TURN_COST);
+    table.addMotion(yaw, Vec(0, 0, (yaw + ANGLE - 1) % ANGLE), TURN_COST);
+  }
+
+  const auto cb_cost = [&cm](
+      const Vec& s, const Vec& e, const Vec& /* v_start */, const Vec& /* v_goal */) -> float
+  {
+    if (cm[e] == 100)
+      return -1;
+    return isTurn(e - s) ? TURN_COST : 1.0f;
+  };
+  // Euclid distance and the in-place turns to the goal yaw as the planner does without the table.
+  const auto cb_cost_estim = [](const Vec& s, const Vec& e) -> float
+  {
+    const int dyaw = std::abs(e[2] - s[2]);
+    return std::hypot(e[0] - s[0], e[1] - s[1]) + std::min(dyaw, ANGLE - dyaw) * TURN_COST;
+  };
+  const auto cb_cost_estim_yaw = [&table, &cb_cost_estim](const Vec& s, const Vec& e) -> float
+  {
+    return std::max(cb_cost_estim(s, e), table.get(Vec(s[0] - e[0], s[1] - e[1], s[2]), e[2]));
+  };
+  const auto cb_search = [&search_list](
+      const Vec& p, const Vec& /* s */, const Vec& /* e */) -> std::vector<Vec>&
+  {
+    return search_list[p[2]];
+  };
+  const auto cb_progress = [](const std::vector<Vec>& /* path_tmp */)
+  {
+    return true;
+  };
+  const auto path_cost = [&cb_cost](const std::vector<Vec>& path) -> float
+  {
+    float cost = 0;
+    for (size_t i = 1; i < path.size(); ++i)
+    {
+      Vec d = path[i] - path[i - 1];
+      d.cycle(ANGLE);
+      cost += isTurn(d) ? TURN_COST : 1.0f;
+    }
+    return cost;
+  };
+
+  // Goal just behind the wall facing to the start side requires turns around the goal.
+  const Vec s(8, 16, 0);
+  const Vec e(20, 16, 2);
+  table.create(e[2]);
+
+  GridAstar<3, 2> as(size);
+  std::vector<Vec> path;
+  ASSERT_TRUE(
+      as.search(
+          s, e, path,
+          cb_cost, cb_cost_estim, cb_search, cb_progress,
+          0, 1.0));
+  const size_t expanded = as.getExpandedNodeNum();
+  const float cost = path_cost(path);
+
+  path.clear();
+  ASSERT_TRUE(
+      as.search(
+          s, e, path,
+          cb_cost, cb_cost_estim_yaw, cb_search, cb_progress,
+          0, 1.0));
+  const size_t expanded_yaw = as.getExpandedNodeNum();
+  const float cost_yaw = path_cost(path);
+
+  std::cout << "Expanded nodes (euclid): " << expanded << std::endl;
+  std::cout << "Expanded nodes (yaw heuristic table): " << expanded_yaw << std::endl;
+  ASSERT_EQ(cost, cost_yaw);
+  ASSERT_LT(expanded_yaw, expanded);
+}
+}  // namespace planner_3d
+}  // namespace planner_cspace
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+
+  return RUN_ALL_TESTS();
+}